@@ -4,31 +4,49 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/net/CBufferPool.cpp \
 ../src/net/CChannel.cpp \
 ../src/net/CIoContextPool.cpp \
+../src/net/CPktBuf.cpp \
 ../src/net/CProtocol.cpp \
 ../src/net/CServer.cpp \
 ../src/net/CSession.cpp \
 ../src/net/CSessionDb.cpp \
-../src/net/CSessionMgr.cpp 
+../src/net/CSessionMgr.cpp \
+../src/net/CTimingWheel.cpp \
+../src/net/CTraffic.cpp \
+../src/net/CUringRelay.cpp \
+../src/net/CUdpDemux.cpp 
 
 OBJS += \
+./src/net/CBufferPool.o \
 ./src/net/CChannel.o \
 ./src/net/CIoContextPool.o \
+./src/net/CPktBuf.o \
 ./src/net/CProtocol.o \
 ./src/net/CServer.o \
 ./src/net/CSession.o \
 ./src/net/CSessionDb.o \
-./src/net/CSessionMgr.o 
+./src/net/CSessionMgr.o \
+./src/net/CTimingWheel.o \
+./src/net/CTraffic.o \
+./src/net/CUringRelay.o \
+./src/net/CUdpDemux.o 
 
 CPP_DEPS += \
+./src/net/CBufferPool.d \
 ./src/net/CChannel.d \
 ./src/net/CIoContextPool.d \
+./src/net/CPktBuf.d \
 ./src/net/CProtocol.d \
 ./src/net/CServer.d \
 ./src/net/CSession.d \
 ./src/net/CSessionDb.d \
-./src/net/CSessionMgr.d 
+./src/net/CSessionMgr.d \
+./src/net/CTimingWheel.d \
+./src/net/CTraffic.d \
+./src/net/CUringRelay.d \
+./src/net/CUdpDemux.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -4,14 +4,20 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/util/CBinLog.cpp \
+../src/util/CCoarseClock.cpp \
 ../src/util/CLogger.cpp \
 ../src/util/util.cpp 
 
 OBJS += \
+./src/util/CBinLog.o \
+./src/util/CCoarseClock.o \
 ./src/util/CLogger.o \
 ./src/util/util.o 
 
 CPP_DEPS += \
+./src/util/CBinLog.d \
+./src/util/CCoarseClock.d \
 ./src/util/CLogger.d \
 ./src/util/util.d 
 
@@ -8,6 +8,7 @@
 #include <iostream>
 #include "net/CServer.hpp"
 #include "util/CLogger.hpp"
+#include "util/CBinLog.hpp"
 #include "util/util.hpp"
 #include "util/CConfig.hpp"
 
@@ -38,7 +39,13 @@ int main(int argc, char* argv[])
 		initLog(gConfig->procName(),
 				gConfig->logPath(),
 				gConfig->logRotationSize(),
-				gConfig->logPrintLevel());
+				gConfig->logPrintLevel(),
+				gConfig->logAsyncQueue(),
+				gConfig->logOverflowBlock(),
+				gConfig->logCpu());
+		if (gConfig->logBinary())
+			CBinLog::init(gConfig->procName(), gConfig->logPath(),
+					gConfig->logBinaryFileSize() * MB, gConfig->logBinaryMaxSize() * MB);
 		ServerPtr server(boost::make_shared<CServer>(gConfig->IOWorkers()));
 		if (!server->start()) {
 			LOGF(ERR) << "server start failed!";
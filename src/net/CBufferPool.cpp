@@ -0,0 +1,126 @@
+/*
+ * CBufferPool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CBufferPool.hpp"
+#include <new>
+#include <algorithm>
+#include <sstream>
+#include "util/CLogger.hpp"
+#include "util/util.hpp"
+
+extern "C"
+{
+#include <sys/mman.h>
+}
+
+asio::io_context::id CBufferPool::id;
+
+CBufferPool::CBufferPool(asio::io_context& io)
+: asio::io_context::service(io)
+, _buf_size(0)
+, _slab_bufs(0)
+, _huge_pages(false)
+, _total(0)
+, _in_use(0)
+, _peak(0)
+, _huge_slabs(0)
+{
+}
+
+CBufferPool::~CBufferPool()
+{
+	release();
+}
+
+bool CBufferPool::init(uint32_t buf_size, uint32_t slab_bufs, bool huge_pages)
+{
+	// 缓冲按 cache line 对齐
+	_buf_size = (buf_size + 63) & ~63u;
+	_slab_bufs = std::max<uint32_t>(slab_bufs, 1);
+	_huge_pages = huge_pages;
+	return true;
+}
+
+void CBufferPool::grow()
+{
+	const size_t HUGE_PAGE = 2 * MB;
+
+	Slab slab;
+	slab.len = static_cast<size_t>(_buf_size) * _slab_bufs;
+	slab.ptr = static_cast<char*>(MAP_FAILED);
+
+	if (_huge_pages) {
+		size_t len = (slab.len + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+		slab.ptr = static_cast<char*>(::mmap(NULL, len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0));
+		if (slab.ptr != MAP_FAILED) {
+			slab.len = len;
+			_huge_slabs.store(_huge_slabs.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+		}
+		else {
+			LOG(WARNING) << "buffer pool huge page slab[" << len << "B] failed, fallback to normal pages.";
+			_huge_pages = false;
+		}
+	}
+
+	if (slab.ptr == MAP_FAILED) {
+		slab.ptr = static_cast<char*>(::mmap(NULL, slab.len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (slab.ptr == MAP_FAILED) {
+			LOG(FATAL) << "buffer pool slab[" << slab.len << "B] mmap failed.";
+			throw std::bad_alloc();
+		}
+	}
+
+	uint32_t n = static_cast<uint32_t>(slab.len / _buf_size);
+	_slabs.push_back(slab);
+	_free.reserve(_free.size() + n);
+	for (uint32_t i = n; i > 0; i--)
+		_free.push_back(slab.ptr + static_cast<size_t>(i - 1) * _buf_size);
+
+	_total.store(_total.load(boost::memory_order_relaxed) + n, boost::memory_order_relaxed);
+}
+
+char* CBufferPool::get()
+{
+	if (_free.empty())
+		grow();
+
+	char* buf = _free.back();
+	_free.pop_back();
+
+	uint32_t in_use = _in_use.load(boost::memory_order_relaxed) + 1;
+	_in_use.store(in_use, boost::memory_order_relaxed);
+	if (in_use > _peak.load(boost::memory_order_relaxed))
+		_peak.store(in_use, boost::memory_order_relaxed);
+	return buf;
+}
+
+void CBufferPool::put(char* buf)
+{
+	_free.push_back(buf);
+	_in_use.store(_in_use.load(boost::memory_order_relaxed) - 1, boost::memory_order_relaxed);
+}
+
+void CBufferPool::release()
+{
+	for (size_t i = 0; i < _slabs.size(); i++)
+		::munmap(_slabs[i].ptr, _slabs[i].len);
+	_slabs.clear();
+	_free.clear();
+}
+
+std::string CBufferPool::report() const
+{
+	uint32_t total = _total.load(boost::memory_order_relaxed);
+	std::stringstream ss;
+	ss << "[buffers: " << _in_use.load(boost::memory_order_relaxed) << "/" << total
+		<< " peak: " << _peak.load(boost::memory_order_relaxed)
+		<< " memory: " << util::formatBytes(static_cast<uint64_t>(total) * _buf_size)
+		<< " huge slabs: " << _huge_slabs.load(boost::memory_order_relaxed) << "]";
+	return ss.str();
+}
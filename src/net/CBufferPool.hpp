@@ -0,0 +1,77 @@
+/*
+ * CBufferPool.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CBUFFERPOOL_HPP_
+#define SRC_NET_CBUFFERPOOL_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/asio/io_context.hpp>
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+// 中继缓冲池 (每个 io_context 一个, 只在本线程使用).
+// 按 slab 整块申请 (可选大页), 通道只在数据报收发期间借用缓冲.
+class CBufferPool : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	explicit CBufferPool(asio::io_context& io);
+	~CBufferPool();
+
+	bool init(uint32_t buf_size, uint32_t slab_bufs, bool huge_pages);
+	uint32_t bufSize() const { return _buf_size; }
+	char* get();
+	void put(char* buf);
+	std::string report() const;
+
+	// 借用一个缓冲, 出作用域归还
+	class Buffer : private boost::noncopyable
+	{
+	public:
+		explicit Buffer(CBufferPool& pool) : _pool(pool), _data(pool.get()) {}
+		~Buffer() { if (_data) _pool.put(_data); }
+		char* data() { return _data; }
+		char* release() { char* data = _data; _data = NULL; return data; }
+		size_t size() const { return _pool.bufSize(); }
+
+	private:
+		CBufferPool& _pool;
+		char* _data;
+	};
+
+private:
+	virtual void shutdown() {}
+	void grow();
+	void release();
+
+	struct Slab
+	{
+		char* ptr;
+		size_t len;
+	};
+
+	uint32_t _buf_size;
+	uint32_t _slab_bufs;
+	bool _huge_pages;
+	std::vector<Slab> _slabs;
+	std::vector<char*> _free;
+
+	// 单线程写, 统计输出可跨线程读
+	boost::atomic<uint32_t> _total;
+	boost::atomic<uint32_t> _in_use;
+	boost::atomic<uint32_t> _peak;
+	boost::atomic<uint32_t> _huge_slabs;
+};
+
+#endif /* SRC_NET_CBUFFERPOOL_HPP_ */
@@ -11,26 +11,39 @@
 #include <boost/ratio.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include "CSession.hpp"
+#include "CUringRelay.hpp"
+#include "CUdpDemux.hpp"
+#include "CIoContextPool.hpp"
+#include "CBufferPool.hpp"
 #include "util/CLogger.hpp"
 #include "util/util.hpp"
+#include "util/CBinLog.hpp"
+
+extern "C"
+{
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+}
 
 CChannel::CEnd::CEnd(asio::io_context& io, uint32_t chann_id, std::string dir,
-		uint32_t mtu, uint32_t port_expired)
-: _strand(io)
-, _id(chann_id)
+		uint32_t mtu, uint32_t port_expired, uint32_t batch_size)
+: _id(chann_id)
 , _dir(dir)
-, _socket(io, asio::ip::udp::v4())
+, _socket(io)
 , _owner_id(0)
-, _buf(mtu)
+, _mtu(mtu)
+, _batch_size(batch_size)
+, _shared(-1)
+, _pending(NULL)
+, _pending_len(0)
+, _send_cnt(0)
+, _sent(0)
 , _port_expired(port_expired)
-, _endtime()
+, _last(0)
 , _opened(false)
+, _bound(false)
 {
-	_socket.set_option(asio::ip::udp::socket::reuse_address(true));
-	_socket.set_option(asio::ip::udp::socket::send_buffer_size(mtu));
-	_socket.set_option(asio::ip::udp::socket::receive_buffer_size(mtu));
-
-	updateTime();
 }
 
 CChannel::CEnd::~CEnd()
@@ -44,7 +57,7 @@ void CChannel::CEnd::stop()
 	_owner_ss.reset();
 }
 
-bool CChannel::CEnd::init(SessionPtr ss)
+bool CChannel::CEnd::init(SessionPtr ss, CUdpDemux* demux)
 {
 	boost::system::error_code ec;
 	asio::ip::tcp::endpoint ep = ss->socket().local_endpoint(ec);
@@ -53,87 +66,189 @@ bool CChannel::CEnd::init(SessionPtr ss)
 		return false;
 	}
 
-	_socket.bind(asio::ip::udp::endpoint(ep.address(), 0), ec);
-	if (ec) {
-		LOG(ERR) << "channel[" << _id << "] " << _dir << " bind udp socket error: " << ec.message();
-		return false;
+	if (demux) {
+		_shared = demux->pick(ep.address(), _id);
+		if (_shared < 0) {
+			LOG(ERR) << "channel[" << _id << "] " << _dir << " no shared udp socket on " << ep.address();
+			return false;
+		}
+		_local_ep = demux->localEndpoint(_shared);
+	}
+	else {
+		if (!open(ep.address()))
+			return false;
+		_local_ep = _socket.local_endpoint(ec);
 	}
 
 	_owner_ss = ss;
 	_owner_id = ss->id();
-	_local_ep = _socket.local_endpoint(ec);
 	ep = ss->socket().remote_endpoint(ec);
 	if (ec) {
 		LOG(ERR) << "channel[" << _id << "] " << _dir << " get remote endpoint error: " << ec.message();
 		return false;
 	}
 	_remote_ep.address(ep.address());
+	return true;
+}
+
+bool CChannel::CEnd::open(const asio::ip::address& addr)
+{
+	boost::system::error_code ec;
+	_socket.open(asio::ip::udp::v4(), ec);
+	if (ec) {
+		LOG(ERR) << "channel[" << _id << "] " << _dir << " open udp socket error: " << ec.message();
+		return false;
+	}
+
+	_socket.set_option(asio::ip::udp::socket::reuse_address(true));
+	_socket.set_option(asio::ip::udp::socket::send_buffer_size(_mtu * _batch_size));
+	_socket.set_option(asio::ip::udp::socket::receive_buffer_size(_mtu * _batch_size));
 
-	if (_port_expired > 0)
-		asio::spawn(_strand, boost::bind(&CChannel::CEnd::portExpiredChecker, this, boost::placeholders::_1));
+	_socket.bind(asio::ip::udp::endpoint(addr, 0), ec);
+	if (ec) {
+		LOG(ERR) << "channel[" << _id << "] " << _dir << " bind udp socket error: " << ec.message();
+		return false;
+	}
+
+	// 就绪后再借缓冲非阻塞读写, 读空或写满返回 would_block
+	_socket.non_blocking(true, ec);
 	return true;
 }
 
-void CChannel::CEnd::portExpiredChecker(asio::yield_context yield)
+void CChannel::CEnd::alloc()
 {
-	using namespace boost::chrono;
+	// 在通道所在线程上首次写入, 内存落在该线程的 NUMA 节点
+	if (_batch_size > 1) {
+		_bufs.resize(_batch_size);
+		_rmsgs.resize(_batch_size);
+		_smsgs.resize(_batch_size);
+		_riovs.resize(_batch_size);
+		_siovs.resize(_batch_size);
+		_addrs.resize(_batch_size);
+	}
+}
 
-	boost::system::error_code ec;
-	boost::posix_time::time_duration td;
-	boost::asio::steady_timer timer(_strand.get_io_context());
-
-	while(_socket.is_open()) {
-		td = boost::posix_time::second_clock::local_time() - _endtime;
-		if (td.total_seconds() >= _port_expired) {
-			LOGF(ERR) << "channel[" << _id <<  "] " << _dir << " expired["
-					<< td.total_seconds() << "] last trans time: " << _endtime;
-			stop();
-			break;
-		}
+void CChannel::CEnd::borrow(CBufferPool& pool)
+{
+	for (size_t i = 0; i < _bufs.size(); i++)
+		_bufs[i] = pool.get();
+}
 
-		timer.expires_from_now(seconds(10));
-		timer.async_wait(yield[ec]);
-		if (ec) {
-			LOGF(ERR) << "channel[" << _id << "] " << _dir << " timer error: " << ec.message();
-			stop();
-			continue;
-		}
+void CChannel::CEnd::giveBack(CBufferPool& pool)
+{
+	for (size_t i = 0; i < _bufs.size(); i++)
+		pool.put(_bufs[i]);
+}
+
+int CChannel::CEnd::recvBatch()
+{
+	for (size_t i = 0; i < _rmsgs.size(); i++) {
+		_riovs[i].iov_base = _bufs[i];
+		_riovs[i].iov_len = _mtu;
+
+		bzero(&_rmsgs[i], sizeof(struct mmsghdr));
+		_rmsgs[i].msg_hdr.msg_name = &_addrs[i];
+		_rmsgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		_rmsgs[i].msg_hdr.msg_iov = &_riovs[i];
+		_rmsgs[i].msg_hdr.msg_iovlen = 1;
 	}
+	return ::recvmmsg(_socket.native_handle(), &_rmsgs[0], _rmsgs.size(), MSG_DONTWAIT, NULL);
+}
+
+void CChannel::CEnd::stageBatch(size_t idx, size_t msg, const struct sockaddr_in* to)
+{
+	_siovs[idx].iov_base = _riovs[msg].iov_base;
+	_siovs[idx].iov_len = _rmsgs[msg].msg_len;
+
+	bzero(&_smsgs[idx], sizeof(struct mmsghdr));
+	_smsgs[idx].msg_hdr.msg_name = const_cast<struct sockaddr_in*>(to);
+	_smsgs[idx].msg_hdr.msg_namelen = to ? sizeof(struct sockaddr_in) : 0;
+	_smsgs[idx].msg_hdr.msg_iov = &_siovs[idx];
+	_smsgs[idx].msg_hdr.msg_iovlen = 1;
+}
+
+bool CChannel::CEnd::expired()
+{
+	uint32_t idle_secs = idle();
+	if (idle_secs < _port_expired)
+		return false;
+
+	LOGF(ERR) << "channel[" << _id <<  "] " << _dir << " expired[" << idle_secs << "s]";
+	return true;
 }
 
 CChannel::CChannel(asio::io_context& io,
 		uint32_t id,
 		uint32_t mtu,
 		uint32_t port_expired,
-		uint32_t display_interval)
+		uint32_t display_interval,
+		uint32_t batch_size,
+		bool io_uring,
+		bool shared_port)
 : _id(id)
-, _src_end(io, id, "src", mtu, port_expired)
-, _dst_end(io, id, "dst", mtu, port_expired)
+, _token(0)
+, _src_end(io, id, "src", mtu, port_expired, std::min<uint32_t>(batch_size, MAX_BATCH_SIZE))
+, _dst_end(io, id, "dst", mtu, port_expired, std::min<uint32_t>(batch_size, MAX_BATCH_SIZE))
 , _strand(io)
-, _up_bytes(0)
-, _up_packs(0)
-, _down_bytes(0)
-, _down_packs(0)
-, _start_pt(boost::posix_time::microsec_clock::local_time())
+, _worker_traffic(&asio::use_service<CWorkerTraffic>(io).traffic())
+, _counters(asio::use_service<CWorkerTraffic>(io).enabled())
+, _start_ms(CCoarseClock::nowMs())
+, _up_bytes_prev(0)
+, _up_packs_prev(0)
+, _down_bytes_prev(0)
+, _down_packs_prev(0)
+, _wheel(&asio::use_service<CTimingWheel>(io))
+, _expire_entry(*this)
 , _display_timer(io)
 , _display_interval(display_interval)
+, _uring(NULL)
+, _up_slot(-1)
+, _down_slot(-1)
+, _demux(NULL)
+, _demux_pos(0)
+, _load(&asio::use_service<CContextLoad>(io))
+, _pool(&asio::use_service<CBufferPool>(io))
+, _table(NULL)
 , _started(false)
 {
+	_load->channelOpened();
+
+	// 共享端口优先, 其次 io_uring
+	if (shared_port) {
+		CUdpDemux& demux = asio::use_service<CUdpDemux>(io);
+		if (demux.available())
+			_demux = &demux;
+	}
+
+	if (io_uring && !_demux) {
+		CUringRelay& relay = asio::use_service<CUringRelay>(io);
+		if (relay.available())
+			_uring = &relay;
+	}
 }
 
 CChannel::~CChannel()
 {
 	stop();
+	_load->channelClosed();
+	if (_table)
+		_table->remove(_id);
 	LOGF(TRACE) << "channel[" << _id << "].";
 }
 
 bool CChannel::init(const SessionPtr& src_ss, const SessionPtr& dst_ss)
 {
-	if (!_src_end.init(src_ss)) {
+	// 令牌只用于共享端口: 独占端口模式沿用原有认证, 应答格式不变
+	if (_demux && !util::randomBytes(&_token, sizeof(_token))) {
+		LOG(ERR) << "channel[" << _id << "] generate token error: " << strerror(errno);
 		return false;
 	}
 
-	if (!_dst_end.init(dst_ss))
+	if (!_src_end.init(src_ss, _demux)) {
+		return false;
+	}
+
+	if (!_dst_end.init(dst_ss, _demux))
 		return false;
 
 	if (!src_ss->addSrcChannel(shared_from_this())) {
@@ -166,28 +281,57 @@ void CChannel::stop()
 	if (_started) {
 		_started = false;
 
+		// 关闭后的流量并入会话
+		CTrafficTotal total;
+		total += _traffic;
+
 		SessionPtr ss = _src_end.session().lock();
 		if (ss) {
 			ss->closeSrcChannel(shared_from_this());
+			ss->addTraffic(total);
 		}
 
 		ss = _dst_end.session().lock();
 		if (ss) {
 			ss->closeDstChannel(shared_from_this());
+			ss->addTraffic(total);
+		}
+
+		// 先撤销 io_uring 在途接收, 再关闭 socket
+		if (_uring) {
+			_uring->detach(_up_slot);
+			_uring->detach(_down_slot);
+			_up_slot = _down_slot = -1;
 		}
+		if (_demux)
+			_demux->remove(this);
 		_src_end.stop();
 		_dst_end.stop();
 
+		_wheel->cancel(_expire_entry);
 		boost::system::error_code ignored_ec;
 		_display_timer.cancel(ignored_ec);
 
 		boost::posix_time::time_duration td =
-				boost::posix_time::second_clock::local_time() - _start_pt;
+				boost::posix_time::milliseconds(CCoarseClock::nowMs() - _start_ms);
+
+		for (int i = 0; i < LOG_CLASSES; i++) {
+			if (_log_limits[i].suppressed() > 0)
+				LOG(INFO) << "channel[" << _id << "] " << _log_limits[i].note();
+		}
 
-		LOG(INFO) << "channel[" << _id << "] closed. takes time: {"
-				<< td.hours() << "h:" << td.minutes() << "m:" << td.seconds() << "s}"
-				<< " | TX packets(" << _up_packs << "): " << util::formatBytes(_up_bytes)
-				<< " | RX packets(" << _down_packs << "):" << util::formatBytes(_down_bytes);
+		if (CBinLog::enabled())
+			BLOG(INFO, binlog::FMT_CHANNEL_CLOSED) << _id
+					<< static_cast<int64_t>(td.hours()) << static_cast<int64_t>(td.minutes())
+					<< static_cast<int64_t>(td.seconds())
+					<< total.up_packs << CBinLog::Bytes(total.up_bytes)
+					<< total.down_packs << CBinLog::Bytes(total.down_bytes)
+					<< (total.up_batches > 0 ? total.up_packs / total.up_batches : 0)
+					<< (total.down_batches > 0 ? total.down_packs / total.down_batches : 0);
+		else
+			LOG(INFO) << "channel[" << _id << "] closed. takes time: {"
+					<< td.hours() << "h:" << td.minutes() << "m:" << td.seconds() << "s}"
+					<< " | " << total.str();
 	}
 }
 
@@ -196,305 +340,688 @@ void CChannel::start()
 	if (!_started) {
 		_started = true;
 
-		LOG(TRACE) << "channel[" << _id << "] "
-				<< "("<< _src_end.sessionId()
-				<< ")["    << _src_end.remote()
-				<< " --> " << _src_end.localPort()
-				<< " --> " << _dst_end.localPort()
-				<< " --> " << _dst_end.remote()
-				<< "]("    << _dst_end.sessionId() << ") opened.";
+		if (CBinLog::enabled())
+			BLOG(TRACE, binlog::FMT_CHANNEL_OPENED) << _id << _src_end.sessionId()
+					<< _src_end.remote() << _src_end.localPort()
+					<< _dst_end.localPort() << _dst_end.remote() << _dst_end.sessionId();
+		else
+			LOG(TRACE) << "channel[" << _id << "] "
+					<< "("<< _src_end.sessionId()
+					<< ")["    << _src_end.remote()
+					<< " --> " << _src_end.localPort()
+					<< " --> " << _dst_end.localPort()
+					<< " --> " << _dst_end.remote()
+					<< "]("    << _dst_end.sessionId() << ") opened.";
+
+		// 状态机在通道线程上启动
+		_strand.post(boost::bind(&CChannel::onStart, shared_from_this()));
+	}
+}
 
-		asio::spawn(_src_end._strand, boost::bind(
-				&CChannel::uploader, shared_from_this(), boost::placeholders::_1));
-		asio::spawn(_dst_end._strand, boost::bind(
-				&CChannel::downloader, shared_from_this(), boost::placeholders::_1));
+void CChannel::onStart()
+{
+	if (!_started)
+		return;
 
-		if (_display_interval > 0)
-			asio::spawn(_strand, boost::bind(
-					&CChannel::displayer, shared_from_this(), boost::placeholders::_1));
+	if (_src_end._port_expired > 0) {
+		_src_end.updateTime();
+		_dst_end.updateTime();
+		_wheel->schedule(_expire_entry, _src_end._port_expired);
+	}
+
+	if (_display_interval > 0)
+		waitDisplay();
+
+	if (_demux) {
+		_demux->add(shared_from_this());
+		return;
 	}
+
+	_src_end.alloc();
+	_dst_end.alloc();
+	waitRead(true);
+	waitRead(false);
 }
 
-bool CChannel::srcAuth(asio::yield_context& yield)
+void CChannel::waitRead(bool up)
 {
-	boost::system::error_code ec;
-	size_t bytes = 0;
+	CEnd& in = up ? _src_end : _dst_end;
+	in._socket.async_wait(asio::ip::udp::socket::wait_read,
+			_strand.wrap(boost::bind(&CChannel::onReadable, shared_from_this(), up, asio::placeholders::error)));
+}
 
-	while(_started && !_src_end.opened()) {
-		bytes = _src_end._socket.async_receive_from(asio::buffer(_src_end._buf), _src_end._remote_ep, yield[ec]);
-		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] "
-					<< "("		<< _src_end.sessionId()
-					<< ")["		<< _src_end.remote()
-					<< " --> "	<< _src_end.localPort()
-					<< "](" 	<< _dst_end.sessionId() << ") src receive auth error: " << ec.message();
+void CChannel::waitWrite(bool up)
+{
+	CEnd& out = up ? _dst_end : _src_end;
+	out._socket.async_wait(asio::ip::udp::socket::wait_write,
+			_strand.wrap(boost::bind(&CChannel::onWritable, shared_from_this(), up, asio::placeholders::error)));
+}
 
-			if (!_src_end._socket.is_open()) {
-				stop();
-				return false;
-			}
-			continue;
-		}
-		_src_end.updateTime();
+void CChannel::onReadable(bool up, const boost::system::error_code& ec)
+{
+	CEnd& in = up ? _src_end : _dst_end;
+	if (!_started)
+		return;
 
-		LOG(DEBUG) << "channel[" << _id << "] "
+	if (ec) {
+		LOG_LIMIT(_log_limits[LOG_RECV], ERR) << "channel[" << _id << "] "
 				<< "("		<< _src_end.sessionId()
-				<< ")["		<< _src_end.remote()
-				<< " --> "	<< _src_end.localPort()
-				<< "]("		<< _dst_end.sessionId()
-				<< ") src read auth[" << bytes << "B]: " << util::to_hex(_src_end._buf.data(), bytes);
+				<< ")["		<< in.remote()
+				<< " --> "	<< in.localPort()
+				<< "]("		<< _dst_end.sessionId() << ") " << in._dir << " wait error: " << ec.message();
+
+		if (!in._socket.is_open())
+			stop();
+		else
+			waitRead(up);
+		return;
+	}
+
+	if (!in.opened())
+		authRead(up);
+	else if (in.batched())
+		relayBatch(up);
+	else
+		relay(up);
+}
+
+void CChannel::authRead(bool up)
+{
+	CEnd& in = up ? _src_end : _dst_end;
+	boost::system::error_code ec;
 
-		if (doAuth(_src_end._buf.data(), bytes) && _dst_end.opened())
-			_src_end._opened = true;
+	CBufferPool::Buffer buf(*_pool);
+	size_t bytes = in._socket.receive_from(asio::buffer(buf.data(), buf.size()), in._remote_ep, 0, ec);
+	if (ec == asio::error::would_block) {
+		waitRead(up);
+		return;
+	}
+
+	if (ec || bytes <= 0) {
+		LOG_LIMIT(_log_limits[LOG_RECV], ERR) << "channel[" << _id << "] "
+				<< "("		<< _src_end.sessionId()
+				<< ")["		<< in.remote()
+				<< " --> "	<< in.localPort()
+				<< "](" 	<< _dst_end.sessionId() << ") " << in._dir << " receive auth error: " << ec.message();
+
+		if (!in._socket.is_open())
+			stop();
 		else
-			_src_end.zeroBuf();
+			waitRead(up);
+		return;
+	}
+	in.updateTime();
 
+	if (CBinLog::enabled())
+		BLOG(DEBUG, binlog::FMT_CHANNEL_AUTH_READ) << _id << _src_end.sessionId() << in.remote()
+				<< in.localPort() << _dst_end.sessionId() << in._dir << bytes
+				<< CBinLog::Hex(buf.data(), bytes);
+	else
+		LOG(DEBUG) << "channel[" << _id << "] "
+				<< "("		<< _src_end.sessionId()
+				<< ")["		<< in.remote()
+				<< " --> "	<< in.localPort()
+				<< "]("		<< _dst_end.sessionId()
+				<< ") " << in._dir << " read auth[" << bytes << "B]: " << util::hex(buf.data(), bytes);
+
+	// 源端须等目的端认证后才算打开
+	if (doAuth(buf.data(), bytes) && (!up || _dst_end.opened()))
+		in._opened = true;
+	else
+		memset(buf.data(), 0, bytes);
+
+	if (CBinLog::enabled())
+		BLOG(INFO, binlog::FMT_CHANNEL_AUTH_ECHO) << _id << _src_end.sessionId() << in.remote()
+				<< in.localPort() << _dst_end.sessionId() << in._dir << bytes
+				<< CBinLog::Hex(buf.data(), bytes);
+	else
 		LOG(INFO) << "channel[" << _id << "] "
 				<< "("		<< _src_end.sessionId()
-				<< ")["		<< _src_end.remote()
-				<< " <-- "	<< _src_end.localPort()
+				<< ")["		<< in.remote()
+				<< " <-- "	<< in.localPort()
 				<< "]("		<< _dst_end.sessionId()
-				<< ") src echo auth[" << bytes << "B]: " << util::to_hex(_src_end._buf.data(), bytes);
+				<< ") " << in._dir << " echo auth[" << bytes << "B]: " << util::hex(buf.data(), bytes);
 
-		bytes = _src_end._socket.async_send_to(asio::buffer(_src_end._buf, bytes), _src_end._remote_ep, yield[ec]);
-		if (ec || bytes <= 0) {
-			_src_end._opened = false;
+	// 认证包很小, 直接非阻塞回显; 失败时客户端会重发
+	in._socket.send_to(asio::buffer(buf.data(), bytes), in._remote_ep, 0, ec);
+	if (ec) {
+		in._opened = false;
 
-			LOG(ERR) << "channel[" << _id << "] "
-					<< "("		<< _src_end.sessionId()
-					<< ")["		<< _src_end.remote()
-					<< " <-- "	<< _src_end.localPort()
-					<< "]("		<< _dst_end.sessionId() << ") src echo auth[" << bytes << "B] error: " << ec.message();
+		LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
+				<< "("		<< _src_end.sessionId()
+				<< ")["		<< in.remote()
+				<< " <-- "	<< in.localPort()
+				<< "]("		<< _dst_end.sessionId() << ") " << in._dir
+				<< " echo auth[" << bytes << "B] error: " << ec.message();
 
-			if (!_src_end._socket.is_open()) {
-				stop();
-				return false;
-			}
-			continue;
+		if (!in._socket.is_open()) {
+			stop();
+			return;
 		}
 	}
 
+	if (in.opened())
+		onOpened(up);
+	else
+		waitRead(up);
+}
+
+void CChannel::onOpened(bool up)
+{
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
+
+	if (!up) {
+		boost::system::error_code ec;
+		_dst_end._socket.connect(_dst_end.remote(), ec);
+		if (ec)
+			LOG(ERR) << "channel[" << _id << "] " << "downloader connect error: " << ec.message();
+	}
+
 	LOG(TRACE) << "channel[" << _id
 			<< "] ("   << _src_end.sessionId()
 			<< ")["    << _src_end.remote()
-			<< " --> " << _src_end.localPort()
-			<< " --> " << _dst_end.localPort()
-			<< " --> " << _dst_end.remote()
-			<< "]("    << _dst_end.sessionId() << ") start upload...";
-
-	return true;
+			<< " <--> " << _src_end.localPort()
+			<< " <--> " << _dst_end.localPort()
+			<< " <--> " << _dst_end.remote()
+			<< "]("    << _dst_end.sessionId() << ") start " << (up ? "upload" : "download") << "...";
+
+	if (_uring) {
+		int& slot = up ? _up_slot : _down_slot;
+		slot = _uring->attach(shared_from_this(), up,
+				in._socket.native_handle(), out._socket.native_handle());
+		if (slot >= 0) {
+			LOGF(TRACE) << "channel[" << _id << "] " << in._dir << " handed to uring relay.";
+			return;
+		}
+	}
+	waitRead(up);
 }
 
-void CChannel::uploader(asio::yield_context yield)
+void CChannel::relay(bool up)
 {
-	if (!srcAuth(boost::ref(yield))){
-		LOGF(TRACE) << "channel[" << _id << "] uploader exit!";
-		return;
-	}
-
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
 	boost::system::error_code ec;
+	asio::ip::udp::endpoint ep;
 	size_t bytes = 0;
 
-	asio::ip::udp::endpoint ep;
-	while (_started) {
-		bytes = _src_end._socket.async_receive_from(asio::buffer(_src_end._buf), ep, yield[ec]);
+	// 一次就绪最多转发 RELAY_BURST 个, 读空再等待, 未读空则让出线程后继续
+	for (uint32_t i = 0; i < RELAY_BURST; i++) {
+		CBufferPool::Buffer buf(*_pool);
+		bytes = in._socket.receive_from(asio::buffer(buf.data(), buf.size()), ep, 0, ec);
+		if (ec == asio::error::would_block) {
+			waitRead(up);
+			return;
+		}
+
 		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] "
+			LOG_LIMIT(_log_limits[LOG_RECV], ERR) << "channel[" << _id << "] "
 					<< "(" 		<< _src_end.sessionId()
-					<< ")["		<< _src_end.remote()
-					<< " --> "	<< _src_end.localPort()
-					<< "]("		<< _dst_end.sessionId() << ") upload receive error: " << ec.message();
+					<< ")["		<< in.remote()
+					<< " --> "	<< in.localPort()
+					<< "]("		<< _dst_end.sessionId() << ") " << in._dir << " receive error: " << ec.message();
 
-			if (!_src_end._socket.is_open()) stop();
+			if (!in._socket.is_open()) {
+				stop();
+				return;
+			}
 			continue;
 		}
 
-		if (ep != _src_end.remote()) {
-			if (ep.address() != _src_end.remote().address()) {
-				LOG(ERR) << "channel[" << _id << "] " << "source recv from invalid ip [" << ep << "]";
-				continue;
-			}
-
-			LOG(WARNING) << "channel[" << _id << "] "
-					<< "source remote endpoint change: [" << _src_end.remote() << "] ==> [" << ep << "]";
-
-			_src_end._remote_ep.port(ep.port());
-		}
+		if (up && !checkSrcRemote(ep))
+			continue;
 
-		_src_end.updateTime();
+		in.updateTime();
 		if (bytes <= 2) // 心跳
 			continue;
 
-		bytes = _dst_end._socket.async_send(asio::buffer(_src_end._buf, bytes), yield[ec]);
-		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] "
+		if (!send(up, buf.data(), bytes, ec)) {
+			if (ec == asio::error::would_block) {
+				// 发送缓冲满, 留住这个数据报等可写
+				in._pending = buf.release();
+				in._pending_len = bytes;
+				waitWrite(up);
+				return;
+			}
+
+			LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
 					<< "("		<< _src_end.sessionId()
-					<< ")["		<< _dst_end.remote()
-					<< " --> "	<< _src_end.localPort()
-					<< "]("		<< _dst_end.sessionId() << ") upload send error: " << ec.message();
+					<< ")["		<< in.localPort()
+					<< " --> "	<< out.remote()
+					<< "]("		<< _dst_end.sessionId() << ") " << in._dir << " send error: " << ec.message();
 
-			if (!_dst_end._socket.is_open()) stop();
-			continue;
+			if (!out._socket.is_open()) {
+				stop();
+				return;
+			}
 		}
+	}
+
+	_strand.post(boost::bind(&CChannel::onReadable, shared_from_this(), up, boost::system::error_code()));
+}
+
+bool CChannel::send(bool up, const char* data, size_t bytes, boost::system::error_code& ec)
+{
+	if (up)
+		bytes = _dst_end._socket.send(asio::buffer(data, bytes), 0, ec);
+	else
+		bytes = _src_end._socket.send_to(asio::buffer(data, bytes), _src_end._remote_ep, 0, ec);
+
+	if (ec)
+		return false;
+
+	count(up, bytes, 1);
+	return true;
+}
+
+void CChannel::onWritable(bool up, const boost::system::error_code& ec)
+{
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
+	boost::system::error_code err = ec;
+
+	char* data = in._pending;
+	in._pending = NULL;
+
+	if (!err && _started && !send(up, data, in._pending_len, err) && err == asio::error::would_block) {
+		in._pending = data;
+		waitWrite(up);
+		return;
+	}
+	_pool->put(data);
+
+	if (!_started)
+		return;
 
-		_up_bytes.add(bytes);
-		_up_packs.add(1);
+	if (err) {
+		LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
+				<< "("		<< _src_end.sessionId()
+				<< ")["		<< in.localPort()
+				<< " --> "	<< out.remote()
+				<< "]("		<< _dst_end.sessionId() << ") " << in._dir << " send error: " << err.message();
+
+		if (!out._socket.is_open()) {
+			stop();
+			return;
+		}
 	}
-	LOGF(TRACE) << "channel[" << _id << "] uploader exit!";
+	waitRead(up);
 }
 
-bool CChannel::dstAuth(asio::yield_context& yield)
+void CChannel::relayBatch(bool up)
 {
+	CEnd& in = up ? _src_end : _dst_end;
 	boost::system::error_code ec;
-	size_t bytes = 0;
 
-	while(_started && !_dst_end._opened) {
-		bytes = _dst_end._socket.async_receive_from(asio::buffer(_dst_end._buf), _dst_end._remote_ep, yield[ec]);
-		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] ("
-					<< _src_end.sessionId()
-					<< ")["		<< _dst_end.localPort()
-					<< " <-- "	<< _dst_end.remote()
-					<< "]("		<< _dst_end.sessionId() << ") dst receive auth error: " << ec.message();
+	in.borrow(*_pool);
+	int n = in.recvBatch();
+	if (n <= 0) {
+		int err = errno;
+		in.giveBack(*_pool);
+
+		if (n < 0 && err != EAGAIN && err != EWOULDBLOCK && err != EINTR) {
+			ec.assign(err, boost::system::system_category());
+			LOG_LIMIT(_log_limits[LOG_RECV], ERR) << "channel[" << _id << "] "
+					<< "(" 		<< _src_end.sessionId()
+					<< ")["		<< in.remote()
+					<< " --> "	<< in.localPort()
+					<< "]("		<< _dst_end.sessionId() << ") " << in._dir << " batch receive error: " << ec.message();
 
-			if (!_dst_end._socket.is_open()) {
+			if (!in._socket.is_open()) {
 				stop();
-				return false;
+				return;
 			}
-			continue;
 		}
+		waitRead(up);
+		return;
+	}
 
-		_dst_end.updateTime();
+	size_t cnt = 0;
+	if (up) {
+		asio::ip::udp::endpoint ep;
+		for (int i = 0; i < n; i++) {
+			const struct sockaddr_in& addr = in._addrs[i];
+			ep.address(asio::ip::address_v4(ntohl(addr.sin_addr.s_addr)));
+			ep.port(ntohs(addr.sin_port));
+			if (!checkSrcRemote(ep))
+				continue;
 
-		if (doAuth(_dst_end._buf.data(), bytes))
-			_dst_end._opened = true;
-		else
-			_dst_end.zeroBuf();
+			in.updateTime();
+			if (in._rmsgs[i].msg_len <= 2) // 心跳
+				continue;
 
-		LOG(INFO) << "channel[" << _id << "] "
-				<< "("		<< _src_end.sessionId()
-				<< ")["		<< _dst_end.localPort()
-				<< " <-- "	<< _dst_end.remote()
-				<< "]("		<< _dst_end.sessionId()
-				<< ") dst echo auth[" << bytes << "B]: " << util::to_hex(_dst_end._buf.data(), bytes);
+			in.stageBatch(cnt++, i, NULL);
+		}
+		if (_counters)
+			_traffic.batch(true);
+	}
+	else {
+		// 源端口可能被上行更新, 每批取一次
+		memcpy(&in._to, _src_end._remote_ep.data(), sizeof(in._to));
+		for (int i = 0; i < n; i++) {
+			in.updateTime();
+			if (in._rmsgs[i].msg_len <= 2) // 心跳
+				continue;
 
-		bytes = _dst_end._socket.async_send_to(asio::buffer(_dst_end._buf, bytes), _dst_end._remote_ep, yield[ec]);
-		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] "
-				<< "("		<< _src_end.sessionId()
-				<< ")["		<< _dst_end.localPort()
-				<< " <-- "	<< _dst_end.remote()
-				<< "]("		<< _dst_end.sessionId()
-				<< ") dst echo auth[" << bytes << "B] error: " << ec.message();
+			in.stageBatch(cnt++, i, &in._to);
+		}
+		if (_counters)
+			_traffic.batch(false);
+	}
 
-			if (!_dst_end._socket.is_open()) {
-				stop();
-				return false;
+	in._send_cnt = cnt;
+	in._sent = 0;
+	sendBatch(up);
+}
+
+void CChannel::sendBatch(bool up)
+{
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
+	boost::system::error_code ec;
+	uint64_t bytes = 0;
+	size_t sent = in._sent;
+
+	while (in._sent < in._send_cnt) {
+		int n = ::sendmmsg(out._socket.native_handle(), &in._smsgs[in._sent], in._send_cnt - in._sent, MSG_DONTWAIT);
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				// 发送缓冲满, 留住剩余数据报等可写
+				count(up, bytes, in._sent - sent);
+				out._socket.async_wait(asio::ip::udp::socket::wait_write,
+						_strand.wrap(boost::bind(&CChannel::onBatchWritable, shared_from_this(), up, asio::placeholders::error)));
+				return;
 			}
-			continue;
+
+			ec.assign(errno, boost::system::system_category());
+			LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
+					<< "("		<< _src_end.sessionId()
+					<< ")["		<< in.localPort()
+					<< " --> "	<< out.localPort()
+					<< "]("		<< _dst_end.sessionId() << ") " << in._dir
+					<< " batch send error(" << (in._send_cnt - in._sent) << " dropped): " << ec.message();
+			break;
 		}
+
+		for (int i = 0; i < n; i++)
+			bytes += in._smsgs[in._sent + i].msg_len;
+		in._sent += n;
 	}
 
-	LOG(TRACE) << "channel[" << _id << "] "
-			<< "(" 		<< _src_end.sessionId()
-			<< ")["		<< _src_end.remote()
-			<< " <-- "	<< _src_end.localPort()
-			<< " <-- "	<< _dst_end.localPort()
-			<< " <-- "	<< _dst_end.remote()
-			<< "]("		<< _dst_end.sessionId() << ") start download...";
+	count(up, bytes, in._sent - sent);
+	in.giveBack(*_pool);
 
-	return true;
+	if (!out._socket.is_open()) {
+		stop();
+		return;
+	}
+	waitRead(up);
 }
 
-void CChannel::downloader(asio::yield_context yield)
+void CChannel::onBatchWritable(bool up, const boost::system::error_code& ec)
 {
-	if (!dstAuth(boost::ref(yield))) {
-		LOGF(TRACE) << "channel[" << _id << "] downloader exit!";
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
+
+	if (!ec && _started) {
+		sendBatch(up);
 		return;
 	}
+	in.giveBack(*_pool);
 
-	boost::system::error_code ec;
-	size_t bytes = 0;
+	if (!_started)
+		return;
 
-	_dst_end._socket.connect(_dst_end.remote(), ec);
-	if (ec)
-		LOG(ERR) << "channel[" << _id << "] " << "downloader connect error: " << ec.message();
+	LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
+			<< "("		<< _src_end.sessionId()
+			<< ")["		<< in.localPort()
+			<< " --> "	<< out.localPort()
+			<< "]("		<< _dst_end.sessionId() << ") " << in._dir
+			<< " batch send wait error(" << (in._send_cnt - in._sent) << " dropped): " << ec.message();
+
+	if (!out._socket.is_open())
+		stop();
+	else
+		waitRead(up);
+}
 
-	while (_started) {
-		bytes = _dst_end._socket.async_receive(asio::buffer(_dst_end._buf), yield[ec]);
-		if (ec || bytes <= 0) {
-			LOG(ERR) << "channel[" << _id << "] "
-					<< "("		<< _src_end.sessionId()
-					<< ")[" 	<< _dst_end.localPort()
-					<< " <-- "	<< _dst_end.remote()
-					<< "]("		<< _dst_end.sessionId() << ") download receive error: " << ec.message();
+void CChannel::count(bool up, uint64_t bytes, uint64_t packs)
+{
+	if (!_counters)
+		return;
 
-			if (!_dst_end._socket.is_open()) stop();
-			continue;
-		}
+	_traffic.count(up, bytes, packs);
+	_worker_traffic->count(up, bytes, packs);
+}
+
+void CChannel::onExpire()
+{
+	// 时间轮回调, 与通道同线程; 收包只记时刻, 到期再按最后活动时刻顺延
+	if (!_started)
+		return;
+
+	if (_src_end.expired() || _dst_end.expired()) {
+		ChannelPtr self = shared_from_this();
+		stop();
+		return;
+	}
+
+	uint32_t idle = std::max(_src_end.idle(), _dst_end.idle());
+	_wheel->schedule(_expire_entry, _src_end._port_expired - idle);
+}
+
+void CChannel::waitDisplay()
+{
+	_display_timer.expires_from_now(boost::chrono::seconds(_display_interval));
+	_display_timer.async_wait(_strand.wrap(
+			boost::bind(&CChannel::onDisplay, shared_from_this(), asio::placeholders::error)));
+}
+
+void CChannel::onDisplay(const boost::system::error_code& ec)
+{
+	using namespace util;
+
+	if (!_started) {
+		LOGF(TRACE) << "channel[" << _id << "] displayer exit!";
+		return;
+	}
+
+	if (ec) {
+		LOG(ERR) << "channel[" << _id << "] displayer timer error: " << ec.message();
+		waitDisplay();
+		return;
+	}
+
+	CTrafficTotal t;
+	t += _traffic;
+	if (t.up_packs != _up_packs_prev || t.down_packs != _down_packs_prev) {
+		if (CBinLog::enabled())
+			BLOG(INFO, binlog::FMT_CHANNEL_DISPLAY) << _id << _src_end.sessionId()
+					<< _src_end.remote() << _dst_end.remote() << _dst_end.sessionId()
+					<< CBinLog::Bytes((t.up_bytes - _up_bytes_prev) / _display_interval)
+					<< (t.up_packs - _up_packs_prev) / _display_interval
+					<< CBinLog::Bytes(t.up_bytes) << t.up_packs
+					<< CBinLog::Bytes((t.down_bytes - _down_bytes_prev) / _display_interval)
+					<< (t.down_packs - _down_packs_prev) / _display_interval
+					<< CBinLog::Bytes(t.down_bytes) << t.down_packs
+					<< (t.up_batches > 0 ? t.up_packs / t.up_batches : 0)
+					<< (t.down_batches > 0 ? t.down_packs / t.down_batches : 0);
+		else
+			LOG(INFO) << "channel[" << _id << "] (" << _src_end.sessionId()
+					<< ")["			<< _src_end.remote()
+					<< " <--> " 	<< _dst_end.remote()
+					<< "]("			<< _dst_end.sessionId() << ") "
+					<< "Tx("		<< formatBytes((t.up_bytes - _up_bytes_prev) / _display_interval)
+					<< "ps/"		<< (t.up_packs - _up_packs_prev) / _display_interval
+					<< " pps) {"	<< formatBytes(t.up_bytes) << ", "  << t.up_packs
+					<< " p} | Rx("	<< formatBytes((t.down_bytes - _down_bytes_prev) / _display_interval)
+					<< "ps/"		<< (t.down_packs - _down_packs_prev) / _display_interval
+					<< " pps) {"	<< formatBytes(t.down_bytes) << ", " << t.down_packs
+					<< " p}"
+					<< " batch avg(" << (t.up_batches > 0 ? t.up_packs / t.up_batches : 0)
+					<< "/" << (t.down_batches > 0 ? t.down_packs / t.down_batches : 0) << ")"
+					;
+
+		_up_bytes_prev = t.up_bytes;
+		_down_bytes_prev = t.down_bytes;
+		_up_packs_prev = t.up_packs;
+		_down_packs_prev = t.down_packs;
+	}
+	waitDisplay();
+}
 
+bool CChannel::uringRecv(bool up, const struct sockaddr_in& from, size_t bytes,
+		struct sockaddr_in& to, socklen_t& tolen)
+{
+	if (up) {
+		asio::ip::udp::endpoint ep(asio::ip::address_v4(ntohl(from.sin_addr.s_addr)), ntohs(from.sin_port));
+		if (!checkSrcRemote(ep))
+			return false;
+
+		_src_end.updateTime();
+		tolen = 0;
+	}
+	else {
 		_dst_end.updateTime();
-		if (bytes <= 2) // 心跳
-			continue;
+		memcpy(&to, _src_end._remote_ep.data(), sizeof(to));
+		tolen = sizeof(to);
+	}
+	return bytes > 2; // 心跳不转发
+}
 
-		bytes = _src_end._socket.async_send_to(asio::buffer(_dst_end._buf, bytes), _src_end._remote_ep, yield[ec]);
-		if (ec || bytes <= 0) {
-			LOGF(ERR) << "channel[" << _id << "] "
-					<< "("		<< _src_end.sessionId()
-					<< ")["		<< _dst_end.localPort()
-					<< " <-- "	<< _src_end.remote()
-					<< "]("		<< _dst_end.sessionId() << ") download send error: " << ec.message();
+void CChannel::uringSent(bool up, int res)
+{
+	if (res < 0) {
+		LOG_LIMIT(_log_limits[LOG_SEND], ERR) << "channel[" << _id << "] "
+				<< "("		<< _src_end.sessionId()
+				<< ")["		<< _src_end.remote()
+				<< (up ? " --> " : " <-- ") << _dst_end.remote()
+				<< "]("		<< _dst_end.sessionId() << ") uring "
+				<< (up ? "upload" : "download") << " send error: "
+				<< boost::system::error_code(-res, boost::system::system_category()).message();
+		return;
+	}
+
+	count(up, res, 1);
+}
 
-			if (!_src_end._socket.is_open()) stop();
+// prev 返回此前登记的远端地址: 已绑定为 from 本身, 首次绑定为空
+bool CChannel::demuxBind(int sock, const asio::ip::udp::endpoint& from, const char* buf, size_t bytes,
+		bool& up, asio::ip::udp::endpoint& prev)
+{
+	if (!_started)
+		return false;
+
+	CEnd* ends[] = { &_src_end, &_dst_end };
+	CEnd* end = NULL;
+	CEnd* fresh = NULL;
+	CEnd* moved = NULL;
+	for (size_t i = 0; i < 2; i++) {
+		CEnd* e = ends[i];
+		if (e->_shared != sock || e->remote().address() != from.address())
 			continue;
+
+		if (!e->_bound) {
+			if (!fresh)
+				fresh = e;
+		}
+		else if (e->remote() == from) {
+			end = e;
+			break;
 		}
+		else if (!moved)
+			moved = e;
+	}
 
-		_down_bytes.add(bytes);
-		_down_packs.add(1);
+	prev = asio::ip::udp::endpoint();
+	if (end) {
+		prev = from;
+	}
+	else if (fresh && demuxAuth(buf, bytes)) {
+		end = fresh;
 	}
-	LOGF(TRACE) << "channel[" << _id << "] downloader exit!";
+	else if (moved && demuxAuth(buf, bytes)) {
+		// 同IP换端口 (NAT 重映射): 凭通道号前缀和带令牌的认证包重新绑定, 重新走认证回显
+		LOG_LIMIT(_log_limits[LOG_REMOTE], WARNING) << "channel[" << _id << "] " << moved->_dir
+				<< " remote endpoint change: [" << moved->remote() << "] ==> [" << from << "]";
+		end = moved;
+		prev = end->_remote_ep;
+		end->_opened = false;
+	}
+	else {
+		LOG_LIMIT(_log_limits[LOG_REMOTE], ERR) << "channel[" << _id << "] " << "shared port bind from [" << from << "] rejected, invalid ip or token";
+		return false;
+	}
+
+	end->_remote_ep = from;
+	end->_bound = true;
+	up = (end == &_src_end);
+	return true;
 }
 
-void CChannel::displayer(asio::yield_context yield)
+CChannel::DemuxAction CChannel::demuxRecv(bool up, const asio::ip::udp::endpoint& from, char* buf, size_t bytes,
+		int& sock, asio::ip::udp::endpoint& to)
 {
-	using namespace util;
+	if (!_started)
+		return DEMUX_DROP;
 
-	boost::system::error_code ec;
-	uint64_t up_bytes_prev = 0;
-	uint64_t down_bytes_prev = 0;
-	uint64_t up_packs_prev = 0;
-	uint64_t down_packs_prev = 0;
-
-	while(_started) {
-		_display_timer.expires_from_now(boost::chrono::seconds(_display_interval));
-		_display_timer.async_wait(yield[ec]);
-		if (ec) {
-			LOG(ERR) << "channel[" << _id << "] displayer timer error: " << ec.message();
-			continue;
-		}
+	CEnd& in = up ? _src_end : _dst_end;
+	CEnd& out = up ? _dst_end : _src_end;
+	in.updateTime();
 
-		if (_up_packs == up_packs_prev && _down_packs == down_packs_prev)
-			continue;
+	if (!in._opened) {
+		// 认证包原样回显, 源端须等目的端认证后才算打开
+		if (demuxAuth(buf, bytes) && (!up || _dst_end.opened()))
+			in._opened = true;
+		else
+			memset(buf, 0, bytes);
 
-		LOG(INFO) << "channel[" << _id << "] (" << _src_end.sessionId()
-				<< ")["			<< _src_end.remote()
-				<< " <--> " 	<< _dst_end.remote()
-				<< "]("			<< _dst_end.sessionId() << ") "
-				<< "Tx("		<< formatBytes((_up_bytes - up_bytes_prev) / _display_interval)
-				<< "ps/"		<< (_up_packs - up_packs_prev) / _display_interval
-				<< " pps) {"	<< formatBytes(_up_bytes) << ", "  << _up_packs
-				<< " p} | Rx("	<< formatBytes((_down_bytes - down_bytes_prev) / _display_interval)
-				<< "ps/"		<< (_down_packs - down_packs_prev) / _display_interval
-				<< " pps) {"	<< formatBytes(_down_bytes) << ", " << _down_packs
-				<< " p}"
-				;
+		if (CBinLog::enabled())
+			BLOG(INFO, binlog::FMT_CHANNEL_AUTH_ECHO) << _id << _src_end.sessionId() << from
+					<< in.localPort() << _dst_end.sessionId() << in._dir << bytes
+					<< CBinLog::Hex(buf, bytes);
+		else
+			LOG(INFO) << "channel[" << _id << "] "
+					<< "("		<< _src_end.sessionId()
+					<< ")["		<< from
+					<< " <-- "	<< in.localPort()
+					<< "]("		<< _dst_end.sessionId()
+					<< ") " << in._dir << " echo auth[" << bytes << "B]: " << util::hex(buf, bytes);
+
+		sock = in._shared;
+		to = from;
+		return DEMUX_ECHO;
+	}
+
+	if (bytes <= 2 || !out._bound) // 心跳, 或对端尚未登记
+		return DEMUX_DROP;
+
+	sock = out._shared;
+	to = out._remote_ep;
+	return DEMUX_FORWARD;
+}
 
-		up_bytes_prev = _up_bytes;
-		down_bytes_prev = _down_bytes;
-		up_packs_prev = _up_packs;
-		down_packs_prev = _down_packs;
+void CChannel::demuxSent(bool up, size_t bytes)
+{
+	count(up, bytes, 1);
+}
+
+bool CChannel::checkSrcRemote(const asio::ip::udp::endpoint& ep)
+{
+	if (ep == _src_end.remote())
+		return true;
+
+	if (ep.address() != _src_end.remote().address()) {
+		LOG_LIMIT(_log_limits[LOG_REMOTE], ERR) << "channel[" << _id << "] " << "source recv from invalid ip [" << ep << "]";
+		return false;
 	}
-	LOGF(TRACE) << "channel[" << _id << "] displayer exit!";
+
+	LOG_LIMIT(_log_limits[LOG_REMOTE], WARNING) << "channel[" << _id << "] "
+			<< "source remote endpoint change: [" << _src_end.remote() << "] ==> [" << ep << "]";
+
+	_src_end._remote_ep.port(ep.port());
+	return true;
 }
 
 bool CChannel::doAuth(const char* buf, const size_t bytes)
@@ -503,3 +1030,11 @@ bool CChannel::doAuth(const char* buf, const size_t bytes)
 		return true;
 	return false;
 }
+
+// 共享端口的认证包: 4 字节通道号后须紧跟通道令牌.
+// 同IP的其它用户 (CGNAT) 猜不到令牌, 不能抢绑或劫持已打开的一端
+bool CChannel::demuxAuth(const char* buf, const size_t bytes)
+{
+	return bytes >= sizeof(uint32_t) + sizeof(_token)
+			&& memcmp(buf + sizeof(uint32_t), &_token, sizeof(_token)) == 0;
+}
@@ -21,17 +21,32 @@
 
 #include <boost/thread/mutex.hpp>
 #include <boost/atomic.hpp>
-#include <boost/unordered/unordered_map.hpp>
+#include <boost/unordered/unordered_set.hpp>
 #include <boost/smart_ptr/shared_ptr.hpp>
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/ip/udp.hpp>
-#include <boost/asio/spawn.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/chrono.hpp>
 
+#include "CBufferPool.hpp"
+#include "CTimingWheel.hpp"
+#include "CTraffic.hpp"
+#include "util/CCoarseClock.hpp"
+#include "util/CLogLimiter.hpp"
+#include "util/CSlabTable.hpp"
+
+extern "C"
+{
+#include <sys/socket.h>
+#include <netinet/in.h>
+}
+
 class CSession;
+class CUringRelay;
+class CUdpDemux;
+class CContextLoad;
 
 namespace asio {
 	using namespace boost::asio;
@@ -40,12 +55,20 @@ namespace asio {
 class CChannel : public boost::enable_shared_from_this<CChannel>
 				, public boost::noncopyable
 {
+	friend class CUringRelay;
+	friend class CUdpDemux;
+
 public:
+	typedef CSlabTable<CChannel> Table;
+
 	CChannel(asio::io_context& io,
 			uint32_t id,
 			uint32_t mtu = 1500,
 			uint32_t port_expired = 0,
-			uint32_t display_interval = 0);
+			uint32_t display_interval = 0,
+			uint32_t batch_size = 1,
+			bool io_uring = false,
+			bool shared_port = false);
 	~CChannel();
 
 	bool init(const boost::shared_ptr<CSession>& src_ss,
@@ -55,6 +78,10 @@ public:
 	void stop();
 
 	uint32_t id() { return _id; }
+	uint64_t token() const { return _token; }
+	bool sharedPort() const { return _demux != NULL; }
+	void registered(Table* table) { _table = table; } // 析构时归还 id 槽位
+	Table* table() { return _table; }
 	asio::ip::udp::socket::endpoint_type srcEndpoint() {
 		return _src_end._local_ep;
 	}
@@ -67,37 +94,79 @@ public:
 		return _dst_end.session();
 	}
 
+	// 跨线程读取近似值
+	void traffic(CTrafficTotal& total) const {
+		total += _traffic;
+	}
+
 private:
-	bool srcAuth(asio::yield_context& yield);
-	bool dstAuth(asio::yield_context& yield);
-	void uploader(asio::yield_context yield);
-	void downloader(asio::yield_context yield);
-	void displayer(asio::yield_context yield);
+	class CEnd;
+
+	// 中继状态机: up 为上行(src --> dst), 否则下行; 全部在 _strand 上执行
+	void onStart();
+	void waitRead(bool up);
+	void waitWrite(bool up);
+	void onReadable(bool up, const boost::system::error_code& ec);
+	void onWritable(bool up, const boost::system::error_code& ec);
+	void authRead(bool up);
+	void onOpened(bool up);
+	void relay(bool up);
+	bool send(bool up, const char* data, size_t bytes, boost::system::error_code& ec);
+	void relayBatch(bool up);
+	void sendBatch(bool up);
+	void onBatchWritable(bool up, const boost::system::error_code& ec);
+	void count(bool up, uint64_t bytes, uint64_t packs);
+
+	void onExpire();
+	void waitDisplay();
+	void onDisplay(const boost::system::error_code& ec);
+
 	bool doAuth(const char* buf, const size_t bytes);
+	bool demuxAuth(const char* buf, const size_t bytes);
+	bool checkSrcRemote(const asio::ip::udp::endpoint& ep);
+
+	// io_uring 中继回调, 运行于通道所在 io_context
+	bool uringRecv(bool up, const struct sockaddr_in& from, size_t bytes,
+			struct sockaddr_in& to, socklen_t& tolen);
+	void uringSent(bool up, int res);
+
+	// 共享端口分发回调, 运行于通道所在 io_context
+	enum DemuxAction { DEMUX_DROP, DEMUX_ECHO, DEMUX_FORWARD };
+	bool demuxBind(int sock, const asio::ip::udp::endpoint& from, const char* buf, size_t bytes,
+			bool& up, asio::ip::udp::endpoint& prev);
+	DemuxAction demuxRecv(bool up, const asio::ip::udp::endpoint& from, char* buf, size_t bytes,
+			int& sock, asio::ip::udp::endpoint& to);
+	void demuxSent(bool up, size_t bytes);
 
 private:
 	//////////////////////////////////////////////////////////////
 	class CEnd
 	{
 	public:
-		CEnd(asio::io_context& io, uint32_t chann_id, std::string dir, uint32_t mtu, uint32_t port_expired);
+		CEnd(asio::io_context& io, uint32_t chann_id, std::string dir,
+				uint32_t mtu, uint32_t port_expired, uint32_t batch_size);
 		~CEnd();
-		bool init(boost::shared_ptr<CSession> ss);
+		bool init(boost::shared_ptr<CSession> ss, CUdpDemux* demux);
+		bool open(const asio::ip::address& addr);
+		void alloc();
 		void stop();
-		inline void updateTime() {
-			if (_port_expired > 0)
-				_endtime = boost::posix_time::second_clock::local_time();
-		}
-		void portExpiredChecker(asio::yield_context yield);
+		inline void updateTime() { _last = CCoarseClock::nowSecs(); }
+		uint32_t idle() { return CCoarseClock::nowSecs() - _last; }
+		bool expired();
 		bool opened() { return _opened; }
 		uint16_t localPort() { return _local_ep.port(); }
 		asio::ip::udp::socket::endpoint_type remote() { return _remote_ep; }
 		uint32_t sessionId() { return _owner_id; }
 		boost::weak_ptr<CSession>& session() { return _owner_ss; }
-		void zeroBuf() { std::fill(_buf.begin(), _buf.end(), 0); }
+
+		// 批量收发 (recvmmsg/sendmmsg)
+		bool batched() { return _rmsgs.size() > 1; }
+		void borrow(CBufferPool& pool);
+		void giveBack(CBufferPool& pool);
+		int recvBatch();
+		void stageBatch(size_t idx, size_t msg, const struct sockaddr_in* to);
 
 	public:
-		asio::io_context::strand _strand;
 		uint32_t _id;
 		std::string _dir;
 		asio::ip::udp::socket 	_socket;
@@ -106,88 +175,134 @@ private:
 
 		boost::weak_ptr<CSession> _owner_ss;
 		uint32_t _owner_id;
-		std::vector<char> _buf;
+		uint32_t _mtu;
+		uint32_t _batch_size;
+		int _shared;	// 共享 socket 序号, -1 为独占 socket
+		char* _pending;	// 等可写时留住的数据报
+		size_t _pending_len;
+		std::vector<char*> _bufs; // 批量收发时借用的缓冲
+		size_t _send_cnt; // 本批待发
+		size_t _sent;	// 本批已发
+		struct sockaddr_in _to;
+
+		std::vector<struct mmsghdr> _rmsgs;
+		std::vector<struct mmsghdr> _smsgs;
+		std::vector<struct iovec> _riovs;
+		std::vector<struct iovec> _siovs;
+		std::vector<struct sockaddr_in> _addrs;
 
 		uint32_t _port_expired;
-		boost::posix_time::ptime _endtime;
+		uint32_t _last;	// 最后收包时刻(粗粒度时钟, 秒)
 		bool _opened;
+		bool _bound;	// 共享端口下远端地址已登记
 	};
 	//////////////////////////////////////////////////////////////
 	uint32_t _id;
+	uint64_t _token;	// 共享端口认证令牌, init 时随机生成, 经 PROXY/ACCESS 应答下发给两端
 	CEnd _src_end;
 	CEnd _dst_end;
 
 	asio::io_context::strand _strand;
-	boost::atomic<uint64_t> _up_bytes;
-	boost::atomic<uint64_t> _up_packs;
-	boost::atomic<uint64_t> _down_bytes;
-	boost::atomic<uint64_t> _down_packs;
-	boost::posix_time::ptime _start_pt;
-
+	// 中继错误日志按类别限速
+	enum LogClass { LOG_RECV, LOG_SEND, LOG_REMOTE, LOG_CLASSES };
+	CLogLimiter		_log_limits[LOG_CLASSES];
+
+	CTraffic		_traffic;
+	CTraffic*		_worker_traffic;
+	bool			_counters;
+	uint64_t _start_ms;
+
+	uint64_t _up_bytes_prev;
+	uint64_t _up_packs_prev;
+	uint64_t _down_bytes_prev;
+	uint64_t _down_packs_prev;
+
+	CTimingWheel*	_wheel;
+	CTimingWheel::Timer<CChannel, &CChannel::onExpire> _expire_entry;
 	asio::steady_timer _display_timer;
 	uint32_t 		_display_interval;
 
+	CUringRelay*	_uring;
+	int				_up_slot;
+	int				_down_slot;
+
+	CUdpDemux*		_demux;
+	size_t			_demux_pos;	// 在分发器通道数组中的下标
+	CContextLoad*	_load;
+	CBufferPool*	_pool;
+	Table*			_table;
+
 	boost::atomic<bool> _started;
+
+public:
+	enum { MAX_BATCH_SIZE = 64 };
+	enum { RELAY_BURST = 16 };	// 每次就绪最多转发的数据报数
 };
 
 typedef boost::shared_ptr<CChannel> ChannelPtr;
 
 
+// 会话名下的通道: 只记 id, 通道对象经通道表查找
 class CChannelMap
 {
 public:
 	typedef uint32_t	ChannelId;
-	typedef boost::weak_ptr<CChannel> CChannelWptr;
-	typedef boost::unordered_map<ChannelId, CChannelWptr> Map;
-	typedef Map::value_type ValueType;
-	typedef Map::iterator Iterator;
+	typedef boost::unordered_set<ChannelId> Ids;
+	typedef Ids::iterator Iterator;
+
+	CChannelMap() : _table(NULL) {}
 
 	size_t size() {
 		boost::mutex::scoped_lock lk(_mutex);
-		return _map.size();
+		return _ids.size();
 	}
 
 	bool insert(const ChannelId& id, const ChannelPtr& value) {
 		boost::mutex::scoped_lock lk(_mutex);
-		if (_map.end() != _map.find(id))
+		if (!_ids.insert(id).second)
 			return false;
 
-		_map.insert(ValueType(id, value));
+		_table = value->table();
 		return true;
 	}
 
 	bool remove(const ChannelId& id) {
 		boost::mutex::scoped_lock lk(_mutex);
-		Iterator it = _map.find(id);
-		if (_map.end() == it)
-			return false;
-
-		_map.erase(id);
-		return true;
+		return _ids.erase(id) > 0;
 	}
 
 	bool has(const ChannelId& id) {
 		boost::mutex::scoped_lock lk(_mutex);
-		if (_map.end() == _map.find(id)) {
-			return false;
+		return _ids.find(id) != _ids.end();
+	}
+
+	// 汇总仍在运行的通道流量
+	void traffic(CTrafficTotal& total) {
+		boost::mutex::scoped_lock lk(_mutex);
+		if (!_table)
+			return;
+
+		for (Iterator it = _ids.begin(); it != _ids.end(); ++it) {
+			ChannelPtr chann = _table->get(*it);
+			if (chann)
+				chann->traffic(total);
 		}
-		return true;
 	}
 
 	void stopAll() {
 		boost::mutex::scoped_lock lk(_mutex);
-		for (Iterator it = _map.begin(); it != _map.end();) {
-			CChannelWptr& value = it->second;
-			ChannelPtr chann = value.lock();
+		for (Iterator it = _ids.begin(); _table && it != _ids.end(); ++it) {
+			ChannelPtr chann = _table->get(*it);
 			if (chann)
 				chann->toStop();
-			it = _map.erase(it);
 		}
+		_ids.clear();
 	}
 
 private:
 	mutable boost::mutex _mutex;
-	Map _map;
+	CChannel::Table* _table;	// 通道表全局唯一, 取自登记的通道
+	Ids _ids;
 };
 
 #endif /* SRC_NET_CCHANNEL_HPP_ */
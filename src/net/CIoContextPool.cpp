@@ -5,12 +5,61 @@
  *      Author: root
  */
 #include "CIoContextPool.hpp"
+#include <sstream>
+#include <boost/chrono.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/bind.hpp>
 #include <boost/ref.hpp>
 #include "util/CLogger.hpp"
 #include "util/util.hpp"
 
+asio::io_context::id CContextLoad::id;
+
+CContextLoad::CContextLoad(asio::io_context& io)
+: asio::io_context::service(io)
+, _timer(io)
+, _interval(0)
+, _channels(0)
+, _delay_us(0)
+, _probes(0)
+{
+}
+
+void CContextLoad::shutdown()
+{
+	boost::system::error_code ignored_ec;
+	_timer.cancel(ignored_ec);
+}
+
+void CContextLoad::startProbe(uint32_t interval_ms)
+{
+	_interval = interval_ms;
+	_timer.expires_from_now(boost::chrono::milliseconds(_interval));
+	_timer.async_wait(boost::bind(&CContextLoad::onProbe, this, boost::placeholders::_1));
+}
+
+void CContextLoad::onProbe(const boost::system::error_code& ec)
+{
+	if (ec)
+		return;
+
+	// 只有本线程写, 无需 CAS
+	int64_t late = boost::chrono::duration_cast<boost::chrono::microseconds>(
+			asio::steady_timer::clock_type::now() - _timer.expires_at()).count();
+	uint32_t sample = late > 0 ? static_cast<uint32_t>(late) : 0;
+	uint32_t avg = _delay_us.load(boost::memory_order_relaxed);
+	_delay_us.store(avg - avg / 8 + sample / 8, boost::memory_order_relaxed);
+	_probes.fetch_add(1, boost::memory_order_relaxed);
+
+	startProbe(_interval);
+}
+
+uint64_t CContextLoad::score() const
+{
+	// 通道越多、调度越慢, 分数越高; 每毫秒延迟按一倍负载计
+	return static_cast<uint64_t>(channels() + 1) * (1000 + delay());
+}
+
 CIoContextPool::CIoContextPool(size_t pool_size)
 : _next_context_index(0)
 , _worker_num(0)
@@ -24,6 +73,8 @@ CIoContextPool::CIoContextPool(size_t pool_size)
 		io_context_ptr io = boost::make_shared<asio::io_context>();
 		_io_contexts.push_back(io);
 		_io_context_works.push_back(asio::make_work_guard(*io));
+		_loads.push_back(&asio::use_service<CContextLoad>(*io));
+		_loads.back()->startProbe(PROBE_INTERVAL);
 	}
 }
 
@@ -40,7 +91,8 @@ void CIoContextPool::run()
 						boost::bind(
 								&CIoContextPool::startThread,
 								this,
-								boost::ref(_io_contexts[i])
+								boost::ref(_io_contexts[i]),
+								_cpus.empty() ? -1 : _cpus[i % _cpus.size()]
 						)
 		);
 		threads.push_back(t);
@@ -52,8 +104,13 @@ void CIoContextPool::run()
 	}
 }
 
-void CIoContextPool::startThread(io_context_ptr& io)
+void CIoContextPool::startThread(io_context_ptr& io, int cpu)
 {
+	if (!util::setThreadAffinity(cpu))
+		LOGF(ERR) << "context thread bind cpu[" << cpu << "] failed.";
+	else if (cpu >= 0)
+		LOGF(INFO) << "context thread bind cpu[" << cpu << "].";
+
 	while (!io->stopped()) {
 		try {
 			LOGF(TRACE) << "context thread running. ";
@@ -83,17 +140,39 @@ void CIoContextPool::stop()
 			_io_contexts[i]->stop();
 		}
 		_io_contexts.clear();
+		_loads.clear();
 		LOG(INFO) << "context pool stopped.";
 	}
 }
 
 asio::io_context& CIoContextPool::getIoContext()
 {
-	asio::io_context& io = *_io_contexts[_next_context_index];
+	// 多个线程同时调用, 原子自增取模
+	size_t index = _next_context_index.fetch_add(1, boost::memory_order_relaxed);
+	return *_io_contexts[index % _io_contexts.size()];
+}
 
-	++_next_context_index;
-	if (_next_context_index == _io_contexts.size())
-		_next_context_index = 0;
+asio::io_context& CIoContextPool::getLeastLoaded()
+{
+	size_t index = 0;
+	uint64_t least = _loads[0]->score();
+	for (size_t i = 1; i < _loads.size(); i++) {
+		uint64_t n = _loads[i]->score();
+		if (n < least) {
+			least = n;
+			index = i;
+		}
+	}
+	return *_io_contexts[index];
+}
 
-	return io;
+std::string CIoContextPool::loadReport()
+{
+	std::stringstream ss;
+	for (size_t i = 0; i < _loads.size(); i++) {
+		ss << "[context[" << i << "] channels: " << _loads[i]->channels()
+			<< " delay: " << _loads[i]->delay() << "us"
+			<< " probes: " << _loads[i]->probes() << "]";
+	}
+	return ss.str();
 }
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <list>
+#include <string>
 
 #include <boost/thread.hpp>
 #include <boost/make_shared.hpp>
@@ -17,13 +18,42 @@
 #include <boost/smart_ptr/weak_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <boost/atomic.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 namespace asio {
 	using namespace boost::asio;
 }
 
+// io_context 负载统计 (每个 io_context 一个), 供通道选择线程.
+// 定时探针在本线程上测量定时器到期后被调度的延迟, 反映待处理 handler 的积压.
+class CContextLoad : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	explicit CContextLoad(asio::io_context& io);
+
+	void startProbe(uint32_t interval_ms);
+	void channelOpened() { _channels.fetch_add(1, boost::memory_order_relaxed); }
+	void channelClosed() { _channels.fetch_sub(1, boost::memory_order_relaxed); }
+	uint32_t channels() const { return _channels.load(boost::memory_order_relaxed); }
+	uint32_t delay() const { return _delay_us.load(boost::memory_order_relaxed); }
+	uint64_t probes() const { return _probes.load(boost::memory_order_relaxed); }
+	uint64_t score() const;
+
+private:
+	virtual void shutdown();
+	void onProbe(const boost::system::error_code& ec);
+
+	asio::steady_timer _timer;
+	uint32_t _interval;
+	boost::atomic<uint32_t> _channels; // 活动通道数
+	boost::atomic<uint32_t> _delay_us; // 调度延迟(微秒), 指数平均
+	boost::atomic<uint64_t> _probes; // 探针次数, 停滞说明线程卡住
+};
 
 class CIoContextPool : private boost::noncopyable
 {
@@ -31,19 +61,28 @@ class CIoContextPool : private boost::noncopyable
 	typedef asio::executor_work_guard<asio::io_context::executor_type> io_context_work;
 
 public:
+	enum { PROBE_INTERVAL = 100 }; // 负载探针间隔(毫秒)
+
 	CIoContextPool(size_t pool_size);
 	~CIoContextPool();
 
 	void run();
 	void stop();
 	asio::io_context& getIoContext();
-	void startThread(io_context_ptr& io);
+	asio::io_context& getIoContext(size_t index) { return *_io_contexts[index]; }
+	asio::io_context& getLeastLoaded();
+	std::string loadReport();
+	size_t size() { return _io_contexts.size(); }
+	void startThread(io_context_ptr& io, int cpu);
+	void setCpus(const std::vector<int>& cpus) { _cpus = cpus; }
 	size_t workerNum() { return _worker_num; }
 
 private:
 	std::vector<io_context_ptr > _io_contexts;
 	std::list<io_context_work > _io_context_works;
-	size_t _next_context_index;
+	std::vector<CContextLoad*> _loads;
+	std::vector<int> _cpus; // 第 i 个线程绑定 _cpus[i % n]
+	boost::atomic<size_t> _next_context_index;
 	size_t _worker_num;
 	bool _started;
 };
@@ -0,0 +1,119 @@
+/*
+ * CPktBuf.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CPktBuf.hpp"
+
+// 每线程一个池, 工作线程常驻, 池不回收 (其它线程可能还要往远程链表归还)
+struct CPktBuf::Pool
+{
+	Pool() : free(NULL), free_cnt(0), remote(NULL) {}
+
+	CPktBuf* free;		// 仅所属线程访问
+	uint32_t free_cnt;
+	boost::atomic<CPktBuf*> remote;	// 其它线程归还, 无锁入栈, 所属线程整批取走
+};
+
+__thread CPktBuf::Pool* CPktBuf::_local = NULL;
+
+CPktBuf::CPktBuf()
+: _refs(0)
+, _owner(NULL)
+, _data(_inline)
+, _len(0)
+, _cap(INLINE_SIZE)
+, _next(NULL)
+{
+}
+
+CPktBuf::~CPktBuf()
+{
+	if (_data != _inline)
+		delete[] _data;
+}
+
+void CPktBuf::resize(size_t len)
+{
+	if (len > _cap) {
+		if (_data != _inline)
+			delete[] _data;
+		_data = new char[len];
+		_cap = len;
+	}
+	_len = len;
+}
+
+CPktBuf::Pool& CPktBuf::localPool()
+{
+	if (!_local)
+		_local = new Pool();
+	return *_local;
+}
+
+PktBufPtr CPktBuf::alloc(size_t len)
+{
+	Pool& pool = localPool();
+	if (!pool.free) {
+		// 收回其它线程归还的缓冲, 超出上限的释放
+		CPktBuf* p = pool.remote.exchange(NULL, boost::memory_order_acquire);
+		while (p) {
+			CPktBuf* next = p->_next;
+			if (pool.free_cnt < MAX_CACHED) {
+				p->_next = pool.free;
+				pool.free = p;
+				pool.free_cnt++;
+			}
+			else {
+				delete p;
+			}
+			p = next;
+		}
+	}
+
+	CPktBuf* p = pool.free;
+	if (p) {
+		pool.free = p->_next;
+		pool.free_cnt--;
+		p->_next = NULL;
+	}
+	else {
+		p = new CPktBuf();
+		p->_owner = &pool;
+	}
+
+	p->resize(len);
+	return PktBufPtr(p);
+}
+
+void CPktBuf::recycle(CPktBuf* p)
+{
+	Pool* pool = p->_owner;
+	if (pool == _local && pool->free_cnt >= MAX_CACHED) {
+		delete p;
+		return;
+	}
+
+	if (p->_cap > MAX_CACHED_CAP) {
+		delete[] p->_data;
+		p->_data = p->_inline;
+		p->_cap = INLINE_SIZE;
+	}
+	p->_len = 0;
+
+	if (pool == _local) {
+		p->_next = pool->free;
+		pool->free = p;
+		pool->free_cnt++;
+		return;
+	}
+
+	// 跨线程释放, 挂回所属池
+	CPktBuf* head = pool->remote.load(boost::memory_order_relaxed);
+	do {
+		p->_next = head;
+	} while (!pool->remote.compare_exchange_weak(head, p,
+			boost::memory_order_release, boost::memory_order_relaxed));
+}
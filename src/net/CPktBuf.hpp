@@ -0,0 +1,72 @@
+/*
+ * CPktBuf.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CPKTBUF_HPP_
+#define SRC_NET_CPKTBUF_HPP_
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+extern "C"
+{
+#include <stddef.h>
+#include <stdint.h>
+}
+
+class CPktBuf;
+typedef boost::intrusive_ptr<CPktBuf> PktBufPtr;
+
+// 控制协议发送缓冲: 引用计数, 释放后回到分配线程的空闲链表复用.
+// 在别的线程释放时挂到所属池的远程链表, 由所属线程分配时整批收回.
+// 小包直接用内嵌空间, 大包 (GETPROXIES) 的堆空间随缓冲一起留在池里.
+class CPktBuf : private boost::noncopyable
+{
+public:
+	enum { INLINE_SIZE = 64 };
+	enum { MAX_CACHED = 1024 };		// 每线程最多缓存的空闲缓冲数
+	enum { MAX_CACHED_CAP = 64 * 1024 }; // 超过此容量的堆空间不留池
+
+	static PktBufPtr alloc(size_t len);
+
+	char* data() { return _data; }
+	const char* data() const { return _data; }
+	size_t size() const { return _len; }
+
+	friend void intrusive_ptr_add_ref(CPktBuf* p) {
+		p->_refs.fetch_add(1, boost::memory_order_relaxed);
+	}
+
+	friend void intrusive_ptr_release(CPktBuf* p) {
+		if (p->_refs.fetch_sub(1, boost::memory_order_release) == 1) {
+			boost::atomic_thread_fence(boost::memory_order_acquire);
+			recycle(p);
+		}
+	}
+
+private:
+	CPktBuf();
+	~CPktBuf();
+
+	struct Pool;
+
+	void resize(size_t len);
+	static Pool& localPool();
+	static void recycle(CPktBuf* p);
+
+	boost::atomic<uint32_t> _refs;
+	Pool* _owner;		// 分配线程的池
+	char* _data;
+	size_t _len;
+	size_t _cap;
+	CPktBuf* _next;		// 空闲链表
+	char _inline[INLINE_SIZE];
+
+	static __thread Pool* _local;	// 当前线程的池
+};
+
+#endif /* SRC_NET_CPKTBUF_HPP_ */
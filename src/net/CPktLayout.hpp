@@ -0,0 +1,160 @@
+/*
+ * CPktLayout.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CPKTLAYOUT_HPP_
+#define SRC_NET_CPKTLAYOUT_HPP_
+
+#include <string>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+
+extern "C"
+{
+#include <stddef.h>
+#include <string.h>
+}
+
+// 包体布局描述: 字段按顺序串成类型链表, 编码/解码/长度/边界检查都由模板展开,
+// 全部内联, 没有虚函数.
+// 边界检查: 入口一次检查全部定长部分 (FIXED), 变长字段只再检查自己和其后的定长部分.
+// 字段按主机字节序原样拷贝, 与原协议一致.
+namespace layout {
+
+struct End
+{
+	enum { FIXED = 0 };
+
+	template <typename C>
+	static size_t size(const C&) { return 0; }
+
+	template <typename C>
+	static char* encode(const C&, char* p) { return p; }
+
+	template <typename C>
+	static const char* decode(C&, const char* p, const char*) { return p; }
+};
+
+// 定长字段
+template <typename C, typename T, T C::*M, typename Next = End>
+struct Pod
+{
+	enum { FIXED = sizeof(T) + Next::FIXED };
+
+	static size_t size(const C& c) { return sizeof(T) + Next::size(c); }
+
+	static char* encode(const C& c, char* p) {
+		memcpy(p, &(c.*M), sizeof(T));
+		return Next::encode(c, p + sizeof(T));
+	}
+
+	static const char* decode(C& c, const char* p, const char* end) {
+		memcpy(&(c.*M), p, sizeof(T));
+		return Next::decode(c, p + sizeof(T), end);
+	}
+};
+
+// 可选的末尾定长字段: 包体带了才解码, 否则连同其后字段保留默认值 (兼容不带这些字段的旧客户端).
+// 其后只能再接可选字段.
+template <typename C, typename T, T C::*M, typename Next = End>
+struct OptPod
+{
+	enum { FIXED = 0 };
+
+	static size_t size(const C& c) { return sizeof(T) + Next::size(c); }
+
+	static char* encode(const C& c, char* p) {
+		memcpy(p, &(c.*M), sizeof(T));
+		return Next::encode(c, p + sizeof(T));
+	}
+
+	static const char* decode(C& c, const char* p, const char* end) {
+		if (static_cast<size_t>(end - p) < sizeof(T))
+			return p;
+		memcpy(&(c.*M), p, sizeof(T));
+		return Next::decode(c, p + sizeof(T), end);
+	}
+};
+
+// 1 字节长度前缀的字符串
+template <typename C, std::string C::*M, typename Next = End>
+struct Str8
+{
+	enum { FIXED = 1 + Next::FIXED };
+
+	static size_t size(const C& c) { return 1 + len(c) + Next::size(c); }
+
+	static char* encode(const C& c, char* p) {
+		uint8_t n = len(c);
+		p[0] = static_cast<char>(n);
+		memcpy(p + 1, (c.*M).data(), n);
+		return Next::encode(c, p + 1 + n);
+	}
+
+	static const char* decode(C& c, const char* p, const char* end) {
+		size_t n = static_cast<uint8_t>(p[0]);
+		if (static_cast<size_t>(end - p) < 1 + n + Next::FIXED)
+			return NULL;
+		(c.*M).assign(p + 1, n);
+		return Next::decode(c, p + 1 + n, end);
+	}
+
+private:
+	static uint8_t len(const C& c) {
+		return static_cast<uint8_t>(std::min<size_t>((c.*M).size(), 0xFF));
+	}
+};
+
+// 共享缓冲中的一段, buf 保活到编码完成
+struct Bytes
+{
+	Bytes() : off(0), len(0) {}
+
+	boost::shared_ptr<std::string> buf;
+	size_t off;
+	size_t len;
+};
+
+// 共享缓冲的一段整块拷贝 (只用于响应)
+template <typename C, Bytes C::*M, typename Next = End>
+struct Slice
+{
+	enum { FIXED = Next::FIXED };
+
+	static size_t size(const C& c) { return (c.*M).len + Next::size(c); }
+
+	static char* encode(const C& c, char* p) {
+		const Bytes& b = c.*M;
+		if (b.len > 0)
+			memcpy(p, b.buf->data() + b.off, b.len);
+		return Next::encode(c, p + b.len);
+	}
+};
+
+// 标志为真时才编码其后字段 (只用于响应)
+template <typename C, bool C::*F, typename Next>
+struct If
+{
+	enum { FIXED = 0 };
+
+	static size_t size(const C& c) { return (c.*F) ? Next::size(c) : 0; }
+
+	static char* encode(const C& c, char* p) { return (c.*F) ? Next::encode(c, p) : p; }
+};
+
+// 解码包体, 失败返回 NULL, 成功返回最后一个字段之后的位置
+template <typename L, typename C>
+inline const char* decode(C& c, const char* body, size_t n)
+{
+	if (n < static_cast<size_t>(L::FIXED))
+		return NULL;
+	return L::decode(c, body, body + n);
+}
+
+} // namespace layout
+
+#endif /* SRC_NET_CPKTLAYOUT_HPP_ */
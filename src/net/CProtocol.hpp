@@ -16,6 +16,8 @@
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/unordered/unordered_map.hpp>
 #include <boost/unordered/unordered_set.hpp>
+#include "CPktBuf.hpp"
+#include "CPktLayout.hpp"
 
 // 包头定义
 typedef struct
@@ -123,208 +125,244 @@ public:
 	std::string sGuid;
 };
 
-class CReqPktBase
+typedef boost::shared_ptr<std::string> StringPtr;
+
+// 请求包: 包头由会话读出后传入, 包体按 T::Layout 解码
+template <typename T>
+class CReqPkt
 {
 public:
-	virtual ~CReqPktBase() {};
-	virtual bool deserialize(const char* p, const size_t n) = 0;
+	bool deserialize(const TagPktHdr& hdr, const char* body, size_t n) {
+		header = hdr;
+		return layout::decode<typename T::Layout>(static_cast<T&>(*this), body, n) != NULL;
+	}
+
 	TagPktHdr header;
 };
 
 // 登陆请求包
-class CReqLoginPkt : public CReqPktBase
+class CReqLoginPkt : public CReqPkt<CReqLoginPkt>
 {
 public:
-	virtual bool deserialize(const char* p, const size_t n);
+	CReqLoginPkt() : uctype(0), uiPrivateAddr(0) {}
+	bool deserialize(const TagPktHdr& hdr, const char* body, size_t n);
 
 public:
 	uint8_t uctype;
 	std::string szGuid;
 	uint32_t uiPrivateAddr;
+
+	typedef layout::Str8<CReqLoginPkt, &CReqLoginPkt::szGuid,
+			layout::Pod<CReqLoginPkt, uint32_t, &CReqLoginPkt::uiPrivateAddr> > Layout;
 };
 
 // 代理请求包
-class CReqProxyPkt : public CReqPktBase
+class CReqProxyPkt : public CReqPkt<CReqProxyPkt>
 {
 public:
-	virtual bool deserialize(const char* p, const size_t n);
+	CReqProxyPkt() : uiId(0), uiDstId(0) {}
 
 public:
 	uint32_t uiId;
 	uint32_t uiDstId;
 	std::string szGameId;
+
+	typedef layout::Pod<CReqProxyPkt, uint32_t, &CReqProxyPkt::uiId,
+			layout::Pod<CReqProxyPkt, uint32_t, &CReqProxyPkt::uiDstId,
+			layout::Str8<CReqProxyPkt, &CReqProxyPkt::szGameId> > > Layout;
 };
 
-// 获取代理端请求包
-class CReqGetProxiesPkt : public CReqPktBase
+// 获取代理端请求包.
+// 分页扩展: 包体 [id u32][cursor u32], 带 cursor 时应答为 [cnt u8][id u32, addr u32]*cnt[next u32].
+// cursor 是目录里的位置, 从后往前翻: 每页取 cursor 之前最多 PAGE_ENTRIES 个条目,
+// next 为本页第一个条目的位置, 0 表示已取完; 首页 cursor 填 0. 同一会话可能出现两次, 客户端按 id 去重.
+// 不带 cursor 的请求 (包体为空或只有 id) 按原格式应答, 只含前 PAGE_ENTRIES 个条目.
+class CReqGetProxiesPkt : public CReqPkt<CReqGetProxiesPkt>
 {
 public:
-	virtual bool deserialize(const char* p, const size_t n);
+	enum { PAGE_ENTRIES = 0xFF };	// 应答计数只有 1 字节
+	enum { NO_CURSOR = 0xFFFFFFFF };
+
+	CReqGetProxiesPkt() : uiId(0), uiCursor(NO_CURSOR) {}
+	bool paged() const { return uiCursor != static_cast<uint32_t>(NO_CURSOR); }
 
 public:
 	uint32_t uiId;
+	uint32_t uiCursor;
+
+	// 包体可以为空
+	typedef layout::OptPod<CReqGetProxiesPkt, uint32_t, &CReqGetProxiesPkt::uiId,
+			layout::OptPod<CReqGetProxiesPkt, uint32_t, &CReqGetProxiesPkt::uiCursor> > Layout;
 };
 
 /////////////////////////////////////////////////////////////////
-typedef boost::shared_ptr<std::string> StringPtr;
-
-class CRespPktBase
+// 响应包: 按 T::Layout 直接编码进池化发送缓冲, 稳态下不产生堆分配
+template <typename T>
+class CRespPkt
 {
 public:
-	CRespPktBase() : ucErr(0) {}
-	virtual ~CRespPktBase() {}
-	virtual boost::shared_ptr<std::string> serialize(const TagPktHdr& head) = 0;
-	virtual void error(uint8_t err) { ucErr = err; }
-
-protected:
-	virtual uint16_t size() const = 0;
-
-protected:
-	uint8_t ucErr;
+	PktBufPtr serialize(const TagPktHdr& head) const {
+		const T& self = static_cast<const T&>(*this);
+		TagPktHdr hdr = head;
+		hdr.usBodyLen = static_cast<uint16_t>(T::Layout::size(self));
+
+		PktBufPtr pkt = CPktBuf::alloc(sizeof(TagPktHdr) + hdr.usBodyLen);
+		memcpy(pkt->data(), &hdr, sizeof(TagPktHdr));
+		T::Layout::encode(self, pkt->data() + sizeof(TagPktHdr));
+		return pkt;
+	}
 };
 
 // 登陆应答包
-class CRespLogin : public CRespPktBase
+class CRespLogin : public CRespPkt<CRespLogin>
 {
 public:
 	CRespLogin()
-	: CRespPktBase()
+	: ucErr(0)
 	, uiId(0)
 	{}
-	virtual ~CRespLogin(){}
-	virtual boost::shared_ptr<std::string> serialize(const TagPktHdr& head);
 
+	void error(uint8_t err) { ucErr = err; }
 	void id(uint32_t val) { uiId = val; }
 
 private:
-	uint16_t size() const{
-		return static_cast<uint16_t>(
-				sizeof(ucErr) +
-				sizeof(uiId));
-	}
-
-private:
+	uint8_t ucErr;
 	uint32_t uiId;
+
+public:
+	typedef layout::Pod<CRespLogin, uint8_t, &CRespLogin::ucErr,
+			layout::Pod<CRespLogin, uint32_t, &CRespLogin::uiId> > Layout;
 };
 
 // 请求代理应答包
-class CRespProxy : public CRespPktBase
+class CRespProxy : public CRespPkt<CRespProxy>
 {
 public:
 	CRespProxy()
-	: CRespPktBase()
+	: ucErr(0)
 	, uiUdpId(0)
 	, uiUdpAddr(0)
 	, usUdpPort(0)
+	, ullToken(0)
+	, bToken(false)
 	{}
-	virtual ~CRespProxy(){}
-	virtual StringPtr serialize(const TagPktHdr& head);
 
+	void error(uint8_t err) { ucErr = err; }
 	void udpId(uint32_t val) { uiUdpId = val; }
 	void udpAddr(uint32_t val) { uiUdpAddr = val; }
 	void udpPort(uint16_t val) { usUdpPort = val; }
+	void token(uint64_t val) { ullToken = val; bToken = true; }
 
 private:
-	uint16_t size() const{
-		return static_cast<uint16_t>(
-				sizeof(ucErr) +
-				sizeof(uiUdpId) +
-				sizeof(uiUdpAddr) +
-				sizeof(usUdpPort));
-	}
-
-public:
-private:
+	uint8_t ucErr;
 	uint32_t uiUdpId;
 	uint32_t uiUdpAddr;
 	uint16_t usUdpPort;
+	uint64_t ullToken;	// 共享端口的通道认证令牌, 只在共享端口模式下附加
+	bool bToken;
+
+public:
+	typedef layout::Pod<CRespProxy, uint8_t, &CRespProxy::ucErr,
+			layout::Pod<CRespProxy, uint32_t, &CRespProxy::uiUdpId,
+			layout::Pod<CRespProxy, uint32_t, &CRespProxy::uiUdpAddr,
+			layout::Pod<CRespProxy, uint16_t, &CRespProxy::usUdpPort,
+			layout::If<CRespProxy, &CRespProxy::bToken,
+			layout::Pod<CRespProxy, uint64_t, &CRespProxy::ullToken> > > > > > Layout;
 };
 
 // 接入应答包
-class CRespAccess : public CRespPktBase
+class CRespAccess : public CRespPkt<CRespAccess>
 {
 public:
 	CRespAccess()
-	: CRespPktBase()
-	, uiSrcId(0)
+	: uiSrcId(0)
 	, uiUdpId(0)
 	, uiUdpAddr(0)
 	, usUdpPort(0)
 	, uiPrivateAddr(0)
+	, ullToken(0)
+	, bToken(false)
 	{}
-	virtual ~CRespAccess(){}
-	virtual StringPtr serialize(const TagPktHdr& head);
 
 	void srcId(uint32_t val) { uiSrcId = val; }
 	void udpId(uint32_t val) { uiUdpId = val; }
 	void udpAddr(uint32_t val) { uiUdpAddr = val; }
 	void udpPort(uint16_t val) { usUdpPort = val; }
 	void privateAddr(uint32_t val) { uiPrivateAddr = val; }
+	void token(uint64_t val) { ullToken = val; bToken = true; }
 
-private:
-	uint16_t size() const{
-		return static_cast<uint16_t>(
-				sizeof(uiSrcId) +
-				sizeof(uiUdpId) +
-				sizeof(uiUdpAddr) +
-				sizeof(usUdpPort) +
-				sizeof(uiPrivateAddr));
-	}
-
-public:
 private:
 	uint32_t uiSrcId;
 	uint32_t uiUdpId;
 	uint32_t uiUdpAddr;
 	uint16_t usUdpPort;
 	uint32_t uiPrivateAddr;
+	uint64_t ullToken;	// 同 CRespProxy, 两端共用一个令牌
+	bool bToken;
+
+public:
+	typedef layout::Pod<CRespAccess, uint32_t, &CRespAccess::uiSrcId,
+			layout::Pod<CRespAccess, uint32_t, &CRespAccess::uiUdpId,
+			layout::Pod<CRespAccess, uint32_t, &CRespAccess::uiUdpAddr,
+			layout::Pod<CRespAccess, uint16_t, &CRespAccess::usUdpPort,
+			layout::Pod<CRespAccess, uint32_t, &CRespAccess::uiPrivateAddr,
+			layout::If<CRespAccess, &CRespAccess::bToken,
+			layout::Pod<CRespAccess, uint64_t, &CRespAccess::ullToken> > > > > > > Layout;
 };
 
-// 请求获取代理端应答包
-class CRespGetProxies : public CRespPktBase
+// 请求获取代理端应答包: 条目直接从目录快照编码, 分页时再带 next
+class CRespGetProxies : public CRespPkt<CRespGetProxies>
 {
 public:
-	CRespGetProxies(): CRespPktBase(){}
-	virtual ~CRespGetProxies(){}
-	virtual StringPtr serialize(const TagPktHdr& head);
+	CRespGetProxies()
+	: ucCnt(0)
+	, uiNext(0)
+	, bPaged(false)
+	{}
 
-private:
-	uint16_t size() const{
-		return static_cast<uint16_t>(
-				sessions->length());
+	// dir 中从第 start 个条目起的 n 个, 每个条目 SSessionInfo::size() 字节
+	void entries(const StringPtr& dir, size_t start, size_t n) {
+		ucCnt = static_cast<uint8_t>(n);
+		slice.buf = dir;
+		slice.off = start * SSessionInfo::size();
+		slice.len = n * SSessionInfo::size();
 	}
+	void next(uint32_t cursor) { uiNext = cursor; bPaged = true; }
+
+private:
+	uint8_t ucCnt;
+	layout::Bytes slice;
+	uint32_t uiNext;
+	bool bPaged;
+
 public:
-	StringPtr sessions;
+	typedef layout::Pod<CRespGetProxies, uint8_t, &CRespGetProxies::ucCnt,
+			layout::Slice<CRespGetProxies, &CRespGetProxies::slice,
+			layout::If<CRespGetProxies, &CRespGetProxies::bPaged,
+			layout::Pod<CRespGetProxies, uint32_t, &CRespGetProxies::uiNext> > > > Layout;
 };
 
 // 停止代理应答包
-class CRespStopProxy : public CRespPktBase
+class CRespStopProxy : public CRespPkt<CRespStopProxy>
 {
 public:
 	CRespStopProxy()
-	: CRespPktBase()
-	, uiUdpId(0)
+	: uiUdpId(0)
 	, uiUdpAddr(0)
 	, usUdpPort(0)
 	{}
-	virtual ~CRespStopProxy(){}
-	virtual StringPtr serialize(const TagPktHdr& head);
 
 	void udpId(uint32_t val) { uiUdpId = val; }
 	void udpAddr(uint32_t val) { uiUdpAddr = val; }
 	void udpPort(uint16_t val) { usUdpPort = val; }
 
-private:
-	uint16_t size() const{
-		return static_cast<uint16_t>(
-				sizeof(uiUdpId) +
-				sizeof(uiUdpAddr) +
-				sizeof(usUdpPort)
-				);
-	}
 public:
 	uint32_t uiUdpId;
 	uint32_t uiUdpAddr;
 	uint16_t usUdpPort;
+
+	typedef layout::Pod<CRespStopProxy, uint32_t, &CRespStopProxy::uiUdpId,
+			layout::Pod<CRespStopProxy, uint32_t, &CRespStopProxy::uiUdpAddr,
+			layout::Pod<CRespStopProxy, uint16_t, &CRespStopProxy::usUdpPort> > > Layout;
 };
 #endif /* SRC_NET_CPROTOCOL_HPP_ */
@@ -13,7 +13,18 @@
 #include <boost/asio/io_context.hpp>
 #include "util/version.h"
 #include "util/CLogger.hpp"
+#include "util/CBinLog.hpp"
 #include "util/CConfig.hpp"
+#include "CUringRelay.hpp"
+#include "CUdpDemux.hpp"
+#include "CBufferPool.hpp"
+#include "CTimingWheel.hpp"
+#include "CTraffic.hpp"
+
+extern "C"
+{
+#include <sys/socket.h>
+}
 
 CServer::CServer(uint32_t pool_size)
 : _io_context_pool(pool_size)
@@ -27,6 +38,7 @@ CServer::CServer(uint32_t pool_size)
 CServer::~CServer()
 {
 	LOGF(TRACE);
+	CBinLog::finit();
 	finitLog();
 }
 
@@ -81,6 +93,18 @@ asio::io_context& CServer::getContext()
 	return _io_context_pool.getIoContext();
 }
 
+asio::io_context& CServer::getChannelContext(const SessionPtr& src_ss)
+{
+	switch (gConfig->channPlacement()) {
+	case CConfig::PLACE_SESSION:
+		return src_ss->ioContext();
+	case CConfig::PLACE_LEAST_LOADED:
+		return _io_context_pool.getLeastLoaded();
+	default:
+		return getContext();
+	}
+}
+
 bool CServer::start()
 {
 	if (!init()) {
@@ -103,22 +127,71 @@ bool CServer::start()
 
 	_session_mgr->start();
 
+	// 每个工作线程的时间轮同时刷新粗粒度时钟
+	for (size_t i = 0; i < _io_context_pool.size(); i++) {
+		asio::use_service<CTimingWheel>(_io_context_pool.getIoContext(i));
+		asio::use_service<CWorkerTraffic>(_io_context_pool.getIoContext(i)).init(gConfig->channCounters());
+		asio::use_service<CBufferPool>(_io_context_pool.getIoContext(i)).init(
+				gConfig->channMTU(), gConfig->channPoolSlab(), gConfig->channHugePages());
+	}
+
+	if (gConfig->channIoUring()) {
+		for (size_t i = 0; i < _io_context_pool.size(); i++) {
+			CUringRelay& relay = asio::use_service<CUringRelay>(_io_context_pool.getIoContext(i));
+			if (!relay.init(gConfig->channIoUringBuffers(), gConfig->channMTU()))
+				LOG(WARNING) << "context[" << i << "] uring relay unavailable, channels use asio relay.";
+		}
+	}
+
+	if (gConfig->channSharedPorts() > 0) {
+		for (size_t i = 0; i < _io_context_pool.size(); i++) {
+			CUdpDemux& demux = asio::use_service<CUdpDemux>(_io_context_pool.getIoContext(i));
+			if (!demux.init(gConfig->srvIPs(), gConfig->channSharedPorts(), gConfig->channMTU()))
+				LOG(WARNING) << "context[" << i << "] udp demux unavailable, channels use own ports.";
+		}
+	}
+
+	// ReusePort: 每个 io_context 各自监听, 由内核分发连接, 会话留在接收它的线程
 	std::vector<std::string> ips = gConfig->srvIPs();
+	size_t ctxs = gConfig->reusePort() ? _io_context_pool.size() : 1;
 	for (size_t i = 0; i < ips.size(); i++) {
 		asio::ip::tcp::endpoint ep(asio::ip::address::from_string(ips[i]), gConfig->listenPort());
-		asio::spawn(getContext(),
-				boost::bind(&CServer::acceptor, shared_from_this(), i+1, ep, boost::placeholders::_1));
+		for (size_t j = 0; j < ctxs; j++) {
+			asio::io_context& io = gConfig->reusePort() ? _io_context_pool.getIoContext(j) : getContext();
+			asio::spawn(io, boost::bind(&CServer::acceptor, shared_from_this(),
+					i * ctxs + j + 1, boost::ref(io), ep, boost::placeholders::_1));
+		}
 	}
+	_io_context_pool.setCpus(util::parseCpuList(gConfig->workerCpus()));
+
+	if (gConfig->loadReportInterval() > 0)
+		asio::spawn(getContext(), boost::bind(&CServer::loadReporter, shared_from_this(), boost::placeholders::_1));
+
 	_io_context_pool.run();// block here
 	return true;
 }
 
 
-void CServer::acceptor(uint32_t id, asio::ip::tcp::endpoint listen_ep, asio::yield_context yield)
+// SO_REUSEPORT 选项, 符合 asio 的 SettableSocketOption 约定
+class CReusePort
+{
+public:
+	explicit CReusePort(bool on) : _value(on ? 1 : 0) {}
+	template <typename Protocol> int level(const Protocol&) const { return SOL_SOCKET; }
+	template <typename Protocol> int name(const Protocol&) const { return SO_REUSEPORT; }
+	template <typename Protocol> const int* data(const Protocol&) const { return &_value; }
+	template <typename Protocol> size_t size(const Protocol&) const { return sizeof(_value); }
+
+private:
+	int _value;
+};
+
+void CServer::acceptor(uint32_t id, asio::io_context& io, asio::ip::tcp::endpoint listen_ep, asio::yield_context yield)
 {
 	boost::system::error_code ec;
+	bool sharded = gConfig->reusePort();
 
-	asio::ip::tcp::acceptor acceptor(getContext());
+	asio::ip::tcp::acceptor acceptor(io);
 	acceptor.open(listen_ep.protocol(), ec);
 	if (ec) {
 		LOGF(ERR) << "acceptor[" << id << "] open [" << listen_ep << "] failed: " << ec.message();
@@ -126,6 +199,13 @@ void CServer::acceptor(uint32_t id, asio::ip::tcp::endpoint listen_ep, asio::yie
 	}
 
 	acceptor.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+	if (sharded) {
+		acceptor.set_option(CReusePort(true), ec);
+		if (ec) {
+			LOGF(ERR) << "acceptor[" << id << "] set reuse port failed: " << ec.message();
+			return;
+		}
+	}
 	acceptor.bind(listen_ep, ec);
 	if (ec) {
 		LOGF(ERR) << "acceptor[" << id << "] bind [" << listen_ep << "] failed: " << ec.message();
@@ -137,7 +217,7 @@ void CServer::acceptor(uint32_t id, asio::ip::tcp::endpoint listen_ep, asio::yie
 	LOG(INFO) << "acceptor[" << id << "] ["<< listen_ep << "] listenning...";
 	while(_started) {
 		SessionPtr ss = boost::make_shared<CSession>(_session_mgr,
-							 boost::ref(_io_context_pool.getIoContext()),
+							 boost::ref(sharded ? io : _io_context_pool.getIoContext()),
 							 gConfig->freeSessionExpired());
 
 		acceptor.async_accept(ss->socket(), yield[ec]);
@@ -172,6 +252,38 @@ void CServer::acceptor(uint32_t id, asio::ip::tcp::endpoint listen_ep, asio::yie
 	LOGF(ERR) << "acceptor[" << id << "] exit.";
 }
 
+void CServer::loadReporter(asio::yield_context yield)
+{
+	boost::system::error_code ec;
+	asio::steady_timer timer(getContext());
+
+	while (_started) {
+		timer.expires_from_now(boost::chrono::seconds(gConfig->loadReportInterval()));
+		timer.async_wait(yield[ec]);
+		if (ec) {
+			LOGF(ERR) << "load reporter timer error: " << ec.message();
+			continue;
+		}
+
+		CTrafficTotal total;
+		CSendTotal send;
+		CRecvTotal recv;
+		LOG(INFO) << "context load: " << _io_context_pool.loadReport();
+		for (size_t i = 0; i < _io_context_pool.size(); i++) {
+			asio::io_context& io = _io_context_pool.getIoContext(i);
+			total += asio::use_service<CWorkerTraffic>(io).traffic();
+			send += asio::use_service<CWorkerTraffic>(io).send();
+			recv += asio::use_service<CWorkerTraffic>(io).recv();
+			LOG(INFO) << "context[" << i << "] buffer pool: "
+					<< asio::use_service<CBufferPool>(io).report();
+		}
+		if (gConfig->channCounters())
+			LOG(INFO) << "traffic: " << total.str();
+		LOG(INFO) << "session send: " << send.str();
+		LOG(INFO) << "session recv: " << recv.str();
+	}
+}
+
 void CServer::sessionClosed(const SessionPtr& ss)
 {
 	_conn_num.sub(1);
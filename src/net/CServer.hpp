@@ -20,6 +20,7 @@
 #include <boost/asio/signal_set.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/placeholders.hpp>
+#include <boost/asio/spawn.hpp>
 #include <vector>
 
 #include "CIoContextPool.hpp"
@@ -46,9 +47,11 @@ public:
 	void sessionClosed(const SessionPtr& ss);
 	void signalHandle(const boost::system::error_code& ec, int sig);
 	asio::io_context& getContext();
+	asio::io_context& getChannelContext(const SessionPtr& src_ss);
 
 private:
-	void acceptor(uint32_t id, asio::ip::tcp::endpoint ep, asio::yield_context yield);
+	void acceptor(uint32_t id, asio::io_context& io, asio::ip::tcp::endpoint ep, asio::yield_context yield);
+	void loadReporter(asio::yield_context yield);
 
 private:
 	CIoContextPool _io_context_pool;
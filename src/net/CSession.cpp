@@ -18,7 +18,11 @@ CSession::CSession(boost::shared_ptr<CSessionMgr> mgr, asio::io_context& io_cont
 : _mgr(mgr)
 , _strand(io_context)
 , _socket(io_context)
-, _timer(io_context)
+, _wheel(&asio::use_service<CTimingWheel>(io_context))
+, _login_timer(*this)
+, _winflight(0)
+, _send_stats(&asio::use_service<CWorkerTraffic>(io_context).send())
+, _recv_stats(&asio::use_service<CWorkerTraffic>(io_context).recv())
 , _timeout(timeout)
 , _id(0)
 , _session_type(0)
@@ -37,14 +41,16 @@ CSession::~CSession()
 
 void CSession::stop()
 {
+	_wheel->cancel(_login_timer);
+
 	boost::system::error_code ignored_ec;
-	_timer.cancel(ignored_ec);
 	_socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored_ec);
 	_socket.close(ignored_ec);
 
 	if (_started)
 	{
 		_started = false;
+		LOGF(DEBUG) << "session[" << _id << "] traffic: " << traffic().str();
 
 		if (_src_channels.size() > 0)
 			_src_channels.stopAll();
@@ -61,34 +67,41 @@ void CSession::start()
 {
 	if (!_started) {
 		_started = true;
-		_timer.expires_from_now(boost::chrono::seconds(_timeout));
-		_timer.async_wait(
-				boost::bind(&CSession::onTimeout,
-							shared_from_this(),
-							asio::placeholders::error));
+		// 时间轮只在会话线程上操作
+		_strand.post(boost::bind(&CSession::waitLogin, shared_from_this()));
 
 		_socket.set_option(asio::ip::tcp::no_delay(true));
 		doRead();
 	}
 }
 
-void CSession::onTimeout(const boost::system::error_code& ec)
+void CSession::waitLogin()
 {
-	if (!ec)
-		stop();
+	if (_started && !_logined)
+		_wheel->schedule(_login_timer, _timeout);
+}
+
+void CSession::onTimeout()
+{
+	// 时间轮回调, 与会话同线程
+	if (!_started)
+		return;
+
+	LOGF(INFO) << "session[" << _id << "] login timeout.";
+	SessionPtr self = shared_from_this();
+	stop();
 }
 
 void CSession::doRead()
 {
 	if (_started)
 	{
-		asio::async_read(
-			_socket,
-			_rbuf,
-			asio::transfer_exactly(sizeof(TagPktHdr)),
+		// 有多少读多少, 一次读到的完整帧在 onRead 里一并处理
+		_socket.async_read_some(
+			_rbuf.prepare(READ_CHUNK),
 			_strand.wrap(
 					boost::bind(
-						&CSession::onReadHead,
+						&CSession::onRead,
 						shared_from_this(),
 						asio::placeholders::error,
 						asio::placeholders::bytes_transferred))
@@ -96,9 +109,9 @@ void CSession::doRead()
 	}
 }
 
-void CSession::doWrite(const StringPtr& msg)
+void CSession::doWrite(const PktBufPtr& msg)
 {
-	if (msg->length() <= 0)
+	if (msg->size() <= 0)
 		return;
 
 	_strand.post(
@@ -109,80 +122,81 @@ void CSession::doWrite(const StringPtr& msg)
 	);
 }
 
-void CSession::onReadHead(const boost::system::error_code& ec, const size_t bytes)
+void CSession::onRead(const boost::system::error_code& ec, const size_t bytes)
 {
 	if (ec || 0 == bytes) {
-		LOG(ERR) << "session[" << _id << "] read head error: " << ec.message();
+		LOG(ERR) << "session[" << _id << "] read error: " << ec.message();
 		stop();
 		return;
 	}
 
-	if (!checkHead()) {
-		stop();
-		return;
+	_rbuf.commit(bytes);
+	size_t frames = 0;
+	while (_started && _rbuf.size() >= sizeof(TagPktHdr)) {
+		if (!checkHead()) {
+			stop();
+			return;
+		}
+
+		// 不完整的帧留在缓冲里, 等下次读到再拼
+		if (_rbuf.size() < sizeof(TagPktHdr) + _hdr.usBodyLen)
+			break;
+
+		onFrame();
+		frames++;
 	}
+	_recv_stats->read(frames, bytes);
 
-	asio::async_read(
-		_socket,
-		_rbuf,
-		asio::transfer_exactly(_hdr.usBodyLen),
-		_strand.wrap(
-				boost::bind(
-						&CSession::onReadBody,
-						shared_from_this(),
-						asio::placeholders::error,
-						asio::placeholders::bytes_transferred))
-	);
+	doRead();
 }
 
-void CSession::onReadBody(const boost::system::error_code& ec, const size_t bytes)
+void CSession::onFrame()
 {
-	if (ec || 0 == bytes) {
-		LOGF(ERR) << "session[" << _id << "] read body error: " << ec.message();;
-		stop();
-		return;
-	}
-
 	const char* pbuf = asio::buffer_cast<const char*>(_rbuf.data());
-	const size_t nmax = _rbuf.size();
+	const char* body = pbuf + sizeof(_hdr);
 
 	LOG(TRACE) << "session[" << _id << "] read(#REQ_" << _mgr->getFuncName(_hdr.ucFunc) << "#): "
-			<< util::to_hex(pbuf, sizeof(_hdr) + _hdr.usBodyLen);
+			<< util::hex(pbuf, sizeof(_hdr) + _hdr.usBodyLen);
 
+	bool parsed = true;
 	switch (_hdr.ucFunc) {
 	case FUNC::REQ::HEARTBEAT:
 		break;
 	case FUNC::REQ::LOGIN: {
-		boost::shared_ptr<CReqLoginPkt> pkt = boost::make_shared<CReqLoginPkt>();
-		pkt->deserialize(pbuf, nmax);
-		onReqLogin(pkt);
+		CReqLoginPkt pkt;
+		if ((parsed = pkt.deserialize(_hdr, body, _hdr.usBodyLen)))
+			onReqLogin(pkt);
 	}break;
 	case FUNC::REQ::PROXY: {
 		if (_session_type == SESSIONTYPE::CLIENT || _session_type == SESSIONTYPE::ANYONE) {
-			boost::shared_ptr<CReqProxyPkt> pkt = boost::make_shared<CReqProxyPkt>();
-			pkt->deserialize(pbuf, nmax);
-			onReqProxy(pkt);
+			CReqProxyPkt pkt;
+			if ((parsed = pkt.deserialize(_hdr, body, _hdr.usBodyLen)))
+				onReqProxy(pkt);
 		}
 	}break;
 	case FUNC::REQ::GETPROXIES: {
 		if (_session_type == SESSIONTYPE::CLIENT || _session_type == SESSIONTYPE::ANYONE) {
-			boost::shared_ptr<CReqGetProxiesPkt> pkt = boost::make_shared<CReqGetProxiesPkt>();
-			pkt->deserialize(pbuf, nmax);
-			onReqGetProxies(pkt);
+			CReqGetProxiesPkt pkt;
+			if ((parsed = pkt.deserialize(_hdr, body, _hdr.usBodyLen)))
+				onReqGetProxies(pkt);
 		}
 	}break;
 	default:
 		break;
 	}
 
+	if (!parsed)
+		LOGF(ERR) << "session[" << _id << "] parse #REQ_" << _mgr->getFuncName(_hdr.ucFunc)
+				<< "# failed, body length: " << _hdr.usBodyLen;
+
 	_rbuf.consume(sizeof(_hdr) + _hdr.usBodyLen);
-	doRead();
 }
 
-void CSession::writeImpl(const StringPtr& msg)
+void CSession::writeImpl(const PktBufPtr& msg)
 {
 	_sque.push_back(msg);
-	if (_sque.size() > 1)
+	_send_stats->peak_depth.raise(_sque.size());
+	if (_winflight > 0)
 	{
 		LOGF(TRACE) << "session[" << _id << "] queue size: " << _sque.size() << "return.";
 		return;
@@ -192,10 +206,25 @@ void CSession::writeImpl(const StringPtr& msg)
 
 void CSession::write()
 {
-	const StringPtr& msg = _sque[0];
+	// 队列里的消息聚合成一次 writev, 受缓冲数和字节数上限约束
+	size_t nbytes = 0;
+	_wbufs.clear();
+	for (MsgQue::const_iterator it = _sque.begin();
+			it != _sque.end() && _wbufs.size() < MAX_WRITE_IOVS; ++it) {
+		if (!_wbufs.empty() && nbytes + (*it)->size() > MAX_WRITE_BYTES)
+			break;
+		_wbufs.push_back(asio::buffer((*it)->data(), (*it)->size()));
+		nbytes += (*it)->size();
+	}
+	_winflight = _wbufs.size();
+	_send_stats->write(_winflight, nbytes);
+
+	WriteBufs bufs;
+	bufs.first = &_wbufs[0];
+	bufs.last = bufs.first + _wbufs.size();
 	asio::async_write(
 			_socket,
-			asio::buffer(msg->c_str(), msg->length()),
+			bufs,
 			_strand.wrap(
 					boost::bind(
 							&CSession::onWriteComplete,
@@ -209,18 +238,21 @@ void CSession::write()
 
 void CSession::onWriteComplete(const boost::system::error_code& ec, const size_t bytes)
 {
-	StringPtr msg = _sque[0];
-	LOG(TRACE) << "session[" << _id << "] write(#RESP_" << _mgr->getFuncName((*msg)[4]) << "#): "
-			<< util::to_hex(*msg);
-
-	_sque.pop_front();
 	if (ec) {
-		LOGF(ERR) << "session[" << _id << "] write failed(" << bytes << "B): [" << util::to_hex(*msg)
-				<< "] [error: " << ec.message() << "]";
-		return;
+		const PktBufPtr& msg = _sque.front();
+		LOGF(ERR) << "session[" << _id << "] write failed(" << bytes << "B, " << _winflight << " msgs): ["
+				<< util::hex(msg->data(), msg->size()) << "] [error: " << ec.message() << "]";
 	}
 
-	if (!_sque.empty())
+	for (; _winflight > 0; _winflight--) {
+		const PktBufPtr& msg = _sque.front();
+		if (!ec)
+			LOG(TRACE) << "session[" << _id << "] write(#RESP_" << _mgr->getFuncName(msg->data()[4]) << "#): "
+					<< util::hex(msg->data(), msg->size());
+		_sque.pop_front();
+	}
+
+	if (!ec && !_sque.empty())
 		write();
 }
 
@@ -247,13 +279,13 @@ bool CSession::checkHead()
 	return false;
 }
 
-void CSession::onReqLogin(const boost::shared_ptr<CReqLoginPkt>& req)
+void CSession::onReqLogin(const CReqLoginPkt& req)
 {
 	CRespLogin resp;
 	if (!_logined) {
-		_guid = req->szGuid;
-		_private_addr = req->uiPrivateAddr;
-		_session_type = req->uctype;
+		_guid = CHashedString(req.szGuid);
+		_private_addr = req.uiPrivateAddr;
+		_session_type = req.uctype;
 
 		_logined = _mgr->onSessionLogin(shared_from_this());
 
@@ -261,9 +293,7 @@ void CSession::onReqLogin(const boost::shared_ptr<CReqLoginPkt>& req)
 			resp.error(ERRCODE::SUCCESS);
 			resp.id(_id);
 			LOG(INFO) << "session[" << _id << "] (" << getType() << ") <" << guid() << "> login success.";
-
-			boost::system::error_code ignored_ec;
-			_timer.cancel(ignored_ec);
+			_wheel->cancel(_login_timer);
 		}
 		else {
 			resp.error(ERRCODE::LOGINED_FAILED);
@@ -276,28 +306,28 @@ void CSession::onReqLogin(const boost::shared_ptr<CReqLoginPkt>& req)
 		LOGF(INFO) << "session[" << _id << "] <" << guid() << "> login repeat.";
 	}
 
-	StringPtr msg = resp.serialize(req->header);
+	PktBufPtr msg = resp.serialize(req.header);
 	doWrite(msg);
 }
 
-void CSession::onReqProxy(const boost::shared_ptr<CReqProxyPkt>& req)
+void CSession::onReqProxy(const CReqProxyPkt& req)
 {
-	LOGF(INFO) << "session[" << _id << "] request proxy destination[" << req->uiDstId << "]";
+	LOGF(INFO) << "session[" << _id << "] request proxy destination[" << req.uiDstId << "]";
 
-	ChannelPtr chann = _mgr->createChannel(shared_from_this(), req->uiDstId);
+	ChannelPtr chann = _mgr->createChannel(shared_from_this(), req.uiDstId);
 	if (!chann) {
-		LOGF(ERR) << "session[" << _id << "] request proxy destination[" << req->uiDstId << "] no found.";
+		LOGF(ERR) << "session[" << _id << "] request proxy destination[" << req.uiDstId << "] no found.";
 		onRespProxyErr(req, ERRCODE::CREATE_UDP_FAILED);
 		return;
 	}
 
 	SessionPtr dst_ss = chann->getDstSession().lock();
 	if (!dst_ss) {
-		LOGF(ERR) << "session[" << req->uiDstId << "] invalid!";
+		LOGF(ERR) << "session[" << req.uiDstId << "] invalid!";
 		return;
 	}
 	if (!dst_ss->isRuning()) {
-		LOGF(ERR) << "session[" << req->uiDstId << "] no running";
+		LOGF(ERR) << "session[" << req.uiDstId << "] no running";
 		return;
 	}
 
@@ -307,16 +337,19 @@ void CSession::onReqProxy(const boost::shared_ptr<CReqProxyPkt>& req)
 	return;
 }
 
-void CSession::onReqGetProxies(const boost::shared_ptr<CReqGetProxiesPkt>& req)
+void CSession::onReqGetProxies(const CReqGetProxiesPkt& req)
 {
-	StringPtr msg;
+	PktBufPtr msg;
 	{
 		CRespGetProxies resp;
-		resp.sessions = _mgr->getAllSessions();
-		msg = resp.serialize(req->header);
+		if (req.paged())
+			_mgr->getSessionsPage(req.uiCursor, resp);
+		else
+			_mgr->getAllSessions(resp);
+		msg = resp.serialize(req.header);
 	}
 	doWrite(msg);
-	LOG(TRACE) << "session[" << _id << "] get sessions: " << util::to_hex(*msg);
+	LOG(TRACE) << "session[" << _id << "] get sessions: " << util::hex(msg->data(), msg->size());
 }
 
 std::string CSession::getType()
@@ -349,6 +382,24 @@ bool CSession::addDstChannel(const ChannelPtr& chann)
 	return ret;
 }
 
+void CSession::addTraffic(const CTrafficTotal& total)
+{
+	boost::mutex::scoped_lock lk(_traffic_mutex);
+	_closed_traffic += total;
+}
+
+CTrafficTotal CSession::traffic()
+{
+	CTrafficTotal total;
+	{
+		boost::mutex::scoped_lock lk(_traffic_mutex);
+		total = _closed_traffic;
+	}
+	_src_channels.traffic(total);
+	_dst_channels.traffic(total);
+	return total;
+}
+
 void CSession::closeSrcChannel(const ChannelPtr& chann)
 {
 	LOGF(TRACE) << "session[" << _id << "] close channel: " << chann->id();
@@ -363,11 +414,11 @@ void CSession::closeDstChannel(const ChannelPtr& chann)
 	onRespStopProxy(chann->id(), chann->dstEndpoint());
 }
 
-void CSession::onRespAccess(const boost::shared_ptr<CReqProxyPkt>& req, const ChannelPtr& chann)
+void CSession::onRespAccess(const CReqProxyPkt& req, const ChannelPtr& chann)
 {
 	TagPktHdr hdr;
 	bzero(&hdr, sizeof(TagPktHdr));
-	memcpy(&hdr, &req->header, sizeof(TagPktHdr));
+	memcpy(&hdr, &req.header, sizeof(TagPktHdr));
 	hdr.ucFunc = FUNC::RESP::ACCESS;
 
 	CRespAccess resp_dst;
@@ -376,24 +427,28 @@ void CSession::onRespAccess(const boost::shared_ptr<CReqProxyPkt>& req, const Ch
 	resp_dst.udpAddr(chann->dstEndpoint().address().to_v4().to_uint());
 	resp_dst.udpPort(asio::detail::socket_ops::host_to_network_short(chann->dstEndpoint().port()));
 	resp_dst.privateAddr(_private_addr);
+	if (chann->sharedPort())
+		resp_dst.token(chann->token());
 
-	StringPtr msg = resp_dst.serialize(hdr);
+	PktBufPtr msg = resp_dst.serialize(hdr);
 	doWrite(msg);
 }
 
-void CSession::onRespProxyOk(const boost::shared_ptr<CReqProxyPkt>& req, const ChannelPtr& chann)
+void CSession::onRespProxyOk(const CReqProxyPkt& req, const ChannelPtr& chann)
 {
 	CRespProxy resp;
 	resp.error(ERRCODE::SUCCESS);
 	resp.udpId(chann->id());
 	resp.udpAddr(chann->srcEndpoint().address().to_v4().to_uint());
 	resp.udpPort(asio::detail::socket_ops::host_to_network_short(chann->srcEndpoint().port()));
+	if (chann->sharedPort())
+		resp.token(chann->token());
 
-	StringPtr msg = resp.serialize(req->header);
+	PktBufPtr msg = resp.serialize(req.header);
 	doWrite(msg);
 }
 
-void CSession::onRespProxyErr(const boost::shared_ptr<CReqProxyPkt>& req, uint8_t errcode)
+void CSession::onRespProxyErr(const CReqProxyPkt& req, uint8_t errcode)
 {
 	CRespProxy resp;
 	resp.error(errcode);
@@ -401,7 +456,7 @@ void CSession::onRespProxyErr(const boost::shared_ptr<CReqProxyPkt>& req, uint8_
 	resp.udpAddr(0);
 	resp.udpPort(0);
 
-	StringPtr msg = resp.serialize(req->header);
+	PktBufPtr msg = resp.serialize(req.header);
 	doWrite(msg);
 }
 
@@ -420,6 +475,6 @@ void CSession::onRespStopProxy(uint32_t id, const asio::ip::udp::endpoint& ep)
 	hdr.ucFunc = FUNC::RESP::STOPPROXY;
 	hdr.ucKeyIndex = 0x00;
 
-	StringPtr msg = resp.serialize(hdr);
+	PktBufPtr msg = resp.serialize(hdr);
 	doWrite(msg);
 }
@@ -10,6 +10,7 @@
 
 #include <map>
 #include <deque>
+#include <vector>
 #include <string>
 #include <sstream>
 
@@ -23,13 +24,15 @@
 #include <boost/asio/strand.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/udp.hpp>
-#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/streambuf.hpp>
 #include <boost/asio/placeholders.hpp>
 
 #include "CProtocol.hpp"
 #include "CChannel.hpp"
+#include "CTimingWheel.hpp"
+#include "CTraffic.hpp"
 #include "util/CSafeMap.hpp"
+#include "util/CShardedMap.hpp"
 #include "util/util.hpp"
 
 namespace asio {
@@ -41,7 +44,12 @@ class CSessionMgr;
 class CSession : public boost::enable_shared_from_this<CSession>
 {
 public:
-	typedef std::deque<StringPtr> MsgQue;
+	typedef std::deque<PktBufPtr> MsgQue; // 池化缓冲, 写完出队即归还
+
+	// 一次聚合写的上限 (asio 单次 sendmsg 最多 64 个缓冲)
+	enum { MAX_WRITE_IOVS = 64 };
+	enum { MAX_WRITE_BYTES = 64 * 1024 };
+	enum { READ_CHUNK = 4096 };	// 单次读的空间, 放得下一串心跳和普通请求
 
 	CSession(boost::shared_ptr<CSessionMgr> mgr, asio::io_context& io_context, uint32_t timeout);
 	~CSession();
@@ -52,13 +60,15 @@ public:
 	bool isRuning() { return _started; }
 
 	void doRead();
-	void doWrite(const StringPtr& msg);
+	void doWrite(const PktBufPtr& msg);
 
-	std::string& guid() { return _guid; }
+	const std::string& guid() const { return _guid.str; }
+	const CHashedString& guidKey() const { return _guid; }	// 登录时算好哈希, 登记和注销 guid 索引复用
 	bool logined() { return _logined; }
 	void id(uint32_t id) { _id = id; }
 	uint32_t id() { return _id; }
 	asio::ip::tcp::socket& socket() { return _socket; }
+	asio::io_context& ioContext() { return _strand.get_io_context(); }
 	uint32_t type() { return _session_type; }
 	std::string getType();
 
@@ -68,22 +78,38 @@ public:
 	void closeSrcChannel(const ChannelPtr& chann);
 	void closeDstChannel(const ChannelPtr& chann);
 
-	void onRespAccess(const boost::shared_ptr<CReqProxyPkt>& req, const ChannelPtr& chann);
+	void onRespAccess(const CReqProxyPkt& req, const ChannelPtr& chann);
+
+	// 流量: 已关闭通道的累计 + 运行中通道的近似值
+	void addTraffic(const CTrafficTotal& total);
+	CTrafficTotal traffic();
 
 private:
-	void onTimeout(const boost::system::error_code& ec);
-	void onReadHead(const boost::system::error_code& ec, const size_t bytes);
-	void onReadBody(const boost::system::error_code& ec, const size_t bytes);
+	void waitLogin();
+	void onTimeout();
+	void onRead(const boost::system::error_code& ec, const size_t bytes);
+	void onFrame();
 	bool checkHead();
 
-	void onReqLogin(const boost::shared_ptr<CReqLoginPkt>& req);
-	void onReqProxy(const boost::shared_ptr<CReqProxyPkt>& req);
-	void onRespProxyOk(const boost::shared_ptr<CReqProxyPkt>& req, const ChannelPtr& chann);
-	void onRespProxyErr(const boost::shared_ptr<CReqProxyPkt>& req, uint8_t errcode);
-	void onReqGetProxies(const boost::shared_ptr<CReqGetProxiesPkt>& req);
+	void onReqLogin(const CReqLoginPkt& req);
+	void onReqProxy(const CReqProxyPkt& req);
+	void onRespProxyOk(const CReqProxyPkt& req, const ChannelPtr& chann);
+	void onRespProxyErr(const CReqProxyPkt& req, uint8_t errcode);
+	void onReqGetProxies(const CReqGetProxiesPkt& req);
 	void onRespStopProxy(uint32_t id, const asio::ip::udp::endpoint& ep);
 
-	void writeImpl(const StringPtr& msg);
+	// 指向 _wbufs 的缓冲序列, 异步写操作复制它时不拷贝数组
+	struct WriteBufs
+	{
+		typedef asio::const_buffer value_type;
+		typedef const asio::const_buffer* const_iterator;
+		const_iterator begin() const { return first; }
+		const_iterator end() const { return last; }
+		const_iterator first;
+		const_iterator last;
+	};
+
+	void writeImpl(const PktBufPtr& msg);
 	void write();
 	void onWriteComplete(const boost::system::error_code& ec, const size_t bytes);
 
@@ -91,19 +117,26 @@ private:
 	boost::shared_ptr<CSessionMgr> _mgr;
 	asio::io_context::strand _strand;
 	asio::ip::tcp::socket _socket;
-	asio::steady_timer _timer;
+	CTimingWheel*	_wheel;
+	CTimingWheel::Timer<CSession, &CSession::onTimeout> _login_timer; // 登录超时
 	asio::streambuf _rbuf;
 	MsgQue 			_sque;
+	std::vector<asio::const_buffer> _wbufs;
+	size_t			_winflight;	// 正在写的消息数 (_sque 头部)
+	CSendStats*		_send_stats;
+	CRecvStats*		_recv_stats;
 
 	CChannelMap 	_src_channels;
 	CChannelMap		_dst_channels;
+	boost::mutex	_traffic_mutex;
+	CTrafficTotal	_closed_traffic;
 
 	TagPktHdr		_hdr;
 	uint32_t		_timeout;
 	uint32_t 		_id;
 	uint32_t	 	_session_type;
 	uint32_t		_private_addr;
-	std::string		_guid;
+	CHashedString	_guid;
 
 	bool 			_logined;
 	boost::atomic<bool>	_started;
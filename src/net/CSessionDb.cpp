@@ -6,9 +6,11 @@
  */
 
 #include "CSessionDb.hpp"
+#include <algorithm>
 #include <boost/make_shared.hpp>
 #include "util/CLogger.hpp"
 #include "util/util.hpp"
+#include "util/CConfig.hpp"
 
 CSessionDb::CSessionDb(boost::asio::io_context& io_context, std::string addr, uint16_t port, std::string passwd)
 : _redis(io_context)
@@ -16,8 +18,7 @@ CSessionDb::CSessionDb(boost::asio::io_context& io_context, std::string addr, ui
 , _redis_port(port)
 , _redis_passwd(passwd)
 , _thread()
-, _out_buff(boost::make_shared<std::string>(""))
-, _buff_len(0)
+, _dir(boost::make_shared<std::string>())
 , _started(false)
 {
 
@@ -58,10 +59,12 @@ void CSessionDb::stop()
 
 void CSessionDb::worker()
 {
+	if (!util::setThreadAffinity(gConfig->sessionDbCpu()))
+		LOG(ERR) << "session db thread bind cpu[" << gConfig->sessionDbCpu() << "] failed.";
+
 	LOG(INFO) << "session db thread start.";
 	while(_started) {
 		operate();
-		serial();
 	}
 	LOG(INFO) << "session db thread exit.";
 }
@@ -81,6 +84,7 @@ void CSessionDb::operate()
 	case OPT::ADD: {
 		const SSessionInfo& info = item.info;
 		_db.insert(std::make_pair(info.uiId, info));
+		dirAdd(info);
 
 		if (_redis.isConnected()) {
 			std::list<RedisBuffer> args;
@@ -113,6 +117,7 @@ void CSessionDb::operate()
 		SSessionInfo info = it->second;
 
 		_db.erase(info.uiId);
+		dirDel(info.uiId);
 		if (_redis.isConnected()) {
 			std::list<RedisBuffer> args;
 			std::string key = kRedisKeySession+info.sGuid;
@@ -134,32 +139,59 @@ void CSessionDb::operate()
 	_op_stack.pop_front();
 }
 
-void CSessionDb::serial()
+// 返回时持有 _out_mutex, _dir 只有目录自己持有, 可以原地改.
+// 只有 worker 线程改目录, 读者持有期间内容不变, 所以复制不用加锁
+void CSessionDb::dirDetach(boost::mutex::scoped_lock& lk)
 {
-	bzero(_buff, MAX_LENGTH);
-
-	uint8_t cnt = 0;
-	uint16_t max_cnt = static_cast<uint16_t>(MAX_LENGTH / SSessionInfo::size());
-	DbMap::iterator it = _db.begin();
-	for (_buff_len = 1; it != _db.end() && _buff_len < MAX_LENGTH && cnt < max_cnt; ++it) {
-		uint32_t id = it->second.uiId;
-		uint32_t addr = it->second.uiAddr;
+	if (_dir.unique())
+		return;
+
+	OutBuff dir = _dir;
+	lk.unlock();
+	OutBuff copy = boost::make_shared<std::string>();
+	copy->reserve(dir->size() + SSessionInfo::size());	// 紧接着要追加时不必再扩容
+	copy->append(*dir);
+	lk.lock();
+	_dir = copy;
+}
 
-		memcpy(_buff + _buff_len, &id, 4);
-		_buff_len += 4;
+void CSessionDb::dirAdd(const SSessionInfo& info)
+{
+	const size_t size = SSessionInfo::size();
+	if (!_dir_index.insert(std::make_pair(info.uiId, static_cast<uint32_t>(_dir->size() / size))).second)
+		return;
 
-		memcpy(_buff + _buff_len, &addr, 4);
-		_buff_len += 4;
+	char entry[8];
+	memcpy(entry, &info.uiId, 4);
+	memcpy(entry + 4, &info.uiAddr, 4);
 
-		cnt++;
-	}
-	_buff[0] = cnt;
-	_buff[_buff_len] = '\0';
+	boost::mutex::scoped_lock lk(_out_mutex);
+	dirDetach(lk);
+	_dir->append(entry, size);
+}
 
-	{
-		boost::mutex::scoped_lock lk(_out_mutex);
-		_out_buff.reset(new std::string(_buff, _buff_len));
+void CSessionDb::dirDel(uint32_t id)
+{
+	DirIndex::iterator it = _dir_index.find(id);
+	if (it == _dir_index.end())
+		return;
+
+	const size_t size = SSessionInfo::size();
+	uint32_t pos = it->second;
+	_dir_index.erase(it);
+
+	boost::mutex::scoped_lock lk(_out_mutex);
+	dirDetach(lk);
+	size_t last = _dir->size() - size;
+	if (pos * size != last) {
+		char* p = &(*_dir)[0];
+		memcpy(p + pos * size, p + last, size);
+
+		uint32_t moved = 0;
+		memcpy(&moved, p + pos * size, 4);
+		_dir_index[moved] = pos;
 	}
+	_dir->resize(last);
 }
 
 void CSessionDb::add(const SSessionInfo& info)
@@ -186,14 +218,37 @@ void CSessionDb::del(uint32_t id)
 	_op_cond.notify_all();
 }
 
-CSessionDb::OutBuff CSessionDb::output()
+CSessionDb::OutBuff CSessionDb::snapshot()
 {
-	OutBuff buff;
-	{
-		boost::mutex::scoped_lock lk(_out_mutex);
-		buff = _out_buff;
+	boost::mutex::scoped_lock lk(_out_mutex);
+	return _dir;
+}
+
+void CSessionDb::output(CRespGetProxies& resp)
+{
+	OutBuff snap = snapshot();
+	size_t cnt = snap->size() / SSessionInfo::size();
+	size_t n = std::min<size_t>(cnt, MAX_WIRE_ENTRIES);
+	if (n < cnt) {
+		boost::mutex::scoped_lock lk(_out_mutex);	// 限速器不是线程安全的
+		LOG_LIMIT(_trunc_log, WARNING) << "session db output " << n << " of " << cnt
+				<< " sessions to unpaged GETPROXIES, clients need the cursor for the rest.";
 	}
-	return buff;
+	resp.entries(snap, 0, n);
+}
+
+// cursor 是位置, 从后往前翻: 本页取 [cursor - PAGE_ENTRIES, cursor), next 为本页起点, 0 表示已取完.
+// 删除只会把末尾条目移进空位, 追加只加在末尾, 所以未翻到的 [0, cursor) 里在线的会话不会被移到已翻过的位置:
+// 翻页期间一直在线的会话至少出现一次, 被移进未翻区的可能再出现一次, 期间增删的会话可能出现也可能不出现.
+void CSessionDb::page(uint32_t cursor, CRespGetProxies& resp)
+{
+	OutBuff snap = snapshot();
+	size_t cnt = snap->size() / SSessionInfo::size();
+	size_t end = (cursor == 0 || cursor > cnt) ? cnt : cursor;
+	size_t start = end > MAX_WIRE_ENTRIES ? end - MAX_WIRE_ENTRIES : 0;
+
+	resp.entries(snap, start, end - start);
+	resp.next(static_cast<uint32_t>(start));
 }
 
 void CSessionDb::onRedisConnected(bool ok, const std::string& errmsg)
@@ -18,6 +18,7 @@
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include "CProtocol.hpp"
+#include "util/CLogLimiter.hpp"
 #include "redisclient/redisasyncclient.h"
 
 namespace OPT{
@@ -51,6 +52,7 @@ class CSessionDb
 {
 public:
 	typedef boost::unordered_map<uint32_t, SSessionInfo> DbMap;
+	typedef boost::unordered_map<uint32_t, uint32_t> DirIndex;
 	typedef std::deque<OperationItem> OperationStack;
 	typedef boost::shared_ptr<std::string> OutBuff;
 
@@ -62,11 +64,15 @@ public:
 	void add(const SSessionInfo& info);
 	void onSetHandle(bool ok, const std::string& errmsg);
 	void del(uint32_t id);
-	OutBuff output();
+	void output(CRespGetProxies& resp);
+	void page(uint32_t cursor, CRespGetProxies& resp);
 
 private:
 	void operate();
-	void serial();
+	void dirAdd(const SSessionInfo& info);
+	void dirDel(uint32_t id);
+	void dirDetach(boost::mutex::scoped_lock& lk);
+	OutBuff snapshot();
 	void onRedisConnected(bool ok, const std::string& errmsg);
 	void onRedisAuth(const RedisValue &result);
 	void onRedisSetSessionCompleted(uint32_t id, const RedisValue &result);
@@ -83,11 +89,15 @@ public:
 	boost::condition _op_cond;
 	OperationStack _op_stack;
 
+	// GETPROXIES 目录: 线上格式 [id addr]... 的稠密数组, 增加追加到末尾, 删除把末尾条目移进空位,
+	// _dir_index 记 id --> 位置, 每次变更 O(1). 目录本身即发布给读者的快照: 读者在锁内只复制指针,
+	// 应答直接从中编码; worker 线程变更时若仍有读者持有, 先在锁外复制一份再改 (写时复制).
+	// 应答计数只有 1 字节: 分页请求按位置游标从后往前取, 旧请求只给前一页.
+	enum { MAX_WIRE_ENTRIES = CReqGetProxiesPkt::PAGE_ENTRIES };
 	boost::mutex _out_mutex;
-	OutBuff _out_buff;
-	enum { MAX_LENGTH = 2048 };
-	char	_buff[MAX_LENGTH];
-	int		_buff_len;
+	OutBuff		_dir;
+	DirIndex	_dir_index;	// 只在 worker 线程访问
+	CLogLimiter	_trunc_log;
 	bool	_started;
 };
 
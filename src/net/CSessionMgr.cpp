@@ -14,8 +14,6 @@
 CSessionMgr::CSessionMgr(ServerPtr server, std::string rds_addr, uint16_t rds_port, std::string rds_passwd)
 : _server(server)
 , _ss_db(boost::ref(server->getContext()), rds_addr, rds_port, rds_passwd)
-, _session_id(1000)
-, _channel_id(1)
 {
 	_func_name_map.insert(std::make_pair((uint32_t)FUNC::REQ::HEARTBEAT,"HEARTB"));
 	_func_name_map.insert(std::make_pair((uint32_t)FUNC::REQ::LOGIN,	"LOGIN"));
@@ -45,31 +43,24 @@ bool CSessionMgr::stop()
 
 bool CSessionMgr::addSessionWithLock(const SessionId& id, const SessionPtr& ss)
 {
-	boost::mutex::scoped_lock lock(_ss_mutex);
-	if (_ss_map.find(id) != _ss_map.end())
-		return false;
-
-	_ss_map.insert(SessionMap::value_type(id, ss));
-	return true;
+	return _ss_table.set(id, ss);
 }
 
 SessionPtr CSessionMgr::getSessionWithLock(const SessionId& id)
 {
-	boost::mutex::scoped_lock lock(_ss_mutex);
-	Iterator it = _ss_map.find(id);
-	if (it == _ss_map.end())
+	// 所有登录会话都占槽位, 只有 SERVER/ANYONE 能作为代理目标
+	SessionPtr ss = _ss_table.get(id);
+	if (!ss || ss->type() == SESSIONTYPE::CLIENT)
 		return SessionPtr();
-	return it->second.lock();
+	return ss;
 }
 
 void CSessionMgr::closeSessionWithLock(const SessionPtr& ss)
 {
 	if (ss->logined()) {
-		_guid_set.remove(ss->guid());
+		_guid_index.remove(ss->guidKey());
 		_ss_db.del(ss->id());
-
-		boost::mutex::scoped_lock lock(_ss_mutex);
-		_ss_map.erase(ss->id());
+		_ss_table.remove(ss->id());
 	}
 	ServerPtr server = _server.lock();
 	if (server)
@@ -78,26 +69,33 @@ void CSessionMgr::closeSessionWithLock(const SessionPtr& ss)
 
 bool CSessionMgr::onSessionLogin(const SessionPtr& ss)
 {
-	if (!_guid_set.insert(ss->guid())) {
-		LOGF(ERR) << "[guid: " << ss->guid() << "] insert failed.";
-		return false;
-	}
-
-	ss->id(allocSessionId());
-	if (ss->type() == SESSIONTYPE::SERVER || ss->type() == SESSIONTYPE::ANYONE) {
-		if (!addSessionWithLock(ss->id(), ss)) {
-			LOGF(ERR) << "session id[: " << ss->id() << "] insert failed.";
-			_guid_set.remove(ss->guid());
-			return false;
-		}
-
+	// 可能失败的步骤都放在登记 guid 之前, 失败时只需归还 id
+	bool proxy = ss->type() == SESSIONTYPE::SERVER || ss->type() == SESSIONTYPE::ANYONE;
+	asio::ip::tcp::endpoint ep;
+	if (proxy) {
 		boost::system::error_code ec;
-		const asio::ip::tcp::endpoint& ep = ss->socket().remote_endpoint(ec);
+		ep = ss->socket().remote_endpoint(ec);
 		if (ec) {
 			LOGF(ERR) << "get remote endpoint error: " << ec.message();
 			return false;
 		}
+	}
 
+	uint32_t id = _ss_table.reserve();
+	if (!id) {
+		LOGF(ERR) << "[guid: " << ss->guid() << "] alloc session id failed, sessions: " << _ss_table.size();
+		return false;
+	}
+
+	if (!_guid_index.insert(ss->guidKey(), ss)) {
+		LOGF(ERR) << "[guid: " << ss->guid() << "] insert failed.";
+		_ss_table.remove(id);
+		return false;
+	}
+
+	ss->id(id);
+	addSessionWithLock(id, ss);
+	if (proxy) {
 		SSessionInfo info(ss->id(), ep.address().to_v4().to_uint(), ss->guid());
 		_ss_db.add(info);
 	}
@@ -105,9 +103,14 @@ bool CSessionMgr::onSessionLogin(const SessionPtr& ss)
 	return true;
 }
 
-boost::shared_ptr<std::string> CSessionMgr::getAllSessions()
+void CSessionMgr::getAllSessions(CRespGetProxies& resp)
 {
-	return _ss_db.output();
+	_ss_db.output(resp);
+}
+
+void CSessionMgr::getSessionsPage(uint32_t cursor, CRespGetProxies& resp)
+{
+	_ss_db.page(cursor, resp);
 }
 
 ChannelPtr CSessionMgr::createChannel(const SessionPtr& src_ss, const SessionId& dst_id)
@@ -124,13 +127,25 @@ ChannelPtr CSessionMgr::createChannel(const SessionPtr& src_ss, const SessionId&
 		return ChannelPtr();
 	}
 
+	uint32_t chann_id = _chann_table.reserve();
+	if (!chann_id) {
+		LOGF(ERR) << "session[" << src_ss->id() << "] alloc channel id failed, channels: " << _chann_table.size();
+		return ChannelPtr();
+	}
+
 	ChannelPtr chann = boost::make_shared<CChannel> (
-			boost::ref(server->getContext()),
-			allocChannelId(),
+			boost::ref(server->getChannelContext(src_ss)),
+			chann_id,
 			gConfig->channMTU(),
 			gConfig->channPortExpired(),
-			gConfig->channDisplayInterval()
+			gConfig->channDisplayInterval(),
+			gConfig->channBatchSize(),
+			gConfig->channIoUring(),
+			gConfig->channSharedPorts() > 0
 	);
+	// 通道析构时释放槽位
+	_chann_table.set(chann_id, chann);
+	chann->registered(&_chann_table);
 
 	if (!chann->init(src_ss, dst_ss)) {
 		chann->stop();
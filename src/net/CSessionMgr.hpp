@@ -13,7 +13,8 @@
 #include "CSession.hpp"
 #include "CChannel.hpp"
 #include "CSessionDb.hpp"
-#include "util/CSafeSet.hpp"
+#include "util/CShardedMap.hpp"
+#include "util/CSlabTable.hpp"
 
 class CServer;
 class CSessionMgr : public boost::enable_shared_from_this<CSessionMgr>
@@ -22,8 +23,8 @@ class CSessionMgr : public boost::enable_shared_from_this<CSessionMgr>
 public:
 	typedef uint32_t SessionId;
 	typedef boost::weak_ptr<CSession> SessionWptr;
-	typedef boost::unordered_map<SessionId, SessionWptr> SessionMap;
-	typedef SessionMap::iterator Iterator;
+	typedef CSlabTable<CSession> SessionTable;
+	typedef CShardedMap<CHashedString, SessionWptr, CHashedString::Hash> GuidIndex;
 	typedef std::map<uint32_t, std::string> FuncNameMap;
 
 	CSessionMgr(boost::shared_ptr<CServer> server, std::string rds_addr, uint16_t rds_port, std::string rds_passwd);
@@ -37,7 +38,8 @@ public:
 	void closeSessionWithLock(const SessionPtr& ss);
 
 	ChannelPtr createChannel(const SessionPtr& src_ss, const SessionId& dst_id);
-	boost::shared_ptr<std::string> getAllSessions();
+	void getAllSessions(CRespGetProxies& resp);
+	void getSessionsPage(uint32_t cursor, CRespGetProxies& resp);
 	bool onSessionLogin(const SessionPtr& ss);
 
 	std::string getFuncName(uint8_t func)
@@ -51,21 +53,14 @@ public:
 		return ss.str();
 	}
 
-private:
-	uint32_t allocSessionId() { return _session_id.fetch_add(1); }
-	uint32_t allocChannelId() { return _channel_id.fetch_add(1); }
-
 private:
 	boost::weak_ptr<CServer> _server;
-	mutable boost::mutex _ss_mutex;
-	SessionMap _ss_map;
+	SessionTable _ss_table;	// 会话 id 即槽位 + 代数, 查找是数组下标
+	CChannel::Table _chann_table;
 	CSessionDb _ss_db;
 
 	std::map<uint32_t, std::string> _func_name_map;
-	CSafeSet<std::string> _guid_set;
-
-	boost::atomic<uint32_t> _session_id;
-	boost::atomic<uint32_t> _channel_id;
+	GuidIndex _guid_index;	// guid 唯一性和登记在同一次分段操作里完成
 };
 
 typedef boost::shared_ptr<CSessionMgr> SessionMgrPtr;
@@ -0,0 +1,128 @@
+/*
+ * CTimingWheel.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CTimingWheel.hpp"
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/asio/placeholders.hpp>
+#include "util/CLogger.hpp"
+#include "util/CCoarseClock.hpp"
+
+asio::io_context::id CTimingWheel::id;
+
+CTimingWheel::CTimingWheel(asio::io_context& io)
+: asio::io_context::service(io)
+, _timer(io)
+, _base_ms(CCoarseClock::update())
+, _now(0)
+, _size(0)
+{
+	for (size_t i = 0; i < SLOTS; i++)
+		_slots[i].prev = _slots[i].next = &_slots[i];
+	wait();
+}
+
+CTimingWheel::~CTimingWheel()
+{
+}
+
+void CTimingWheel::shutdown()
+{
+	boost::system::error_code ignored_ec;
+	_timer.cancel(ignored_ec);
+
+	for (size_t i = 0; i < SLOTS; i++) {
+		while (_slots[i].next != &_slots[i])
+			unlink(*_slots[i].next);
+	}
+	_size = 0;
+}
+
+void CTimingWheel::link(Link& head, Link& node)
+{
+	node.prev = head.prev;
+	node.next = &head;
+	head.prev->next = &node;
+	head.prev = &node;
+}
+
+void CTimingWheel::unlink(Link& node)
+{
+	node.prev->next = node.next;
+	node.next->prev = node.prev;
+	node.prev = node.next = NULL;
+}
+
+void CTimingWheel::schedule(Entry& entry, uint32_t ticks)
+{
+	cancel(entry);
+
+	ticks = std::max<uint32_t>(ticks, 1);
+	entry._rounds = (ticks - 1) / SLOTS;
+	link(_slots[(_now + ticks) % SLOTS], entry);
+	_size++;
+}
+
+void CTimingWheel::cancel(Entry& entry)
+{
+	if (!entry.scheduled())
+		return;
+
+	unlink(entry);
+	_size--;
+}
+
+void CTimingWheel::wait()
+{
+	_timer.expires_from_now(boost::chrono::milliseconds(TICK_MS));
+	_timer.async_wait(boost::bind(&CTimingWheel::onTick, this, asio::placeholders::error));
+}
+
+void CTimingWheel::onTick(const boost::system::error_code& ec)
+{
+	if (ec == asio::error::operation_aborted)
+		return;
+
+	if (ec)
+		LOG(ERR) << "timing wheel timer error: " << ec.message();
+
+	// 线程繁忙时定时器会迟到, 按时钟把落下的格一并走完
+	uint32_t target = static_cast<uint32_t>((CCoarseClock::update() - _base_ms) / TICK_MS);
+	do {
+		advance();
+	} while (_now < target);
+	wait();
+}
+
+void CTimingWheel::advance()
+{
+	_now++;
+	Link& slot = _slots[_now % SLOTS];
+
+	// 先摘到临时链表再回调, 回调里可以重新调度或取消其它定时项
+	Link expired;
+	expired.prev = expired.next = &expired;
+	for (Link* node = slot.next; node != &slot;) {
+		Entry* entry = static_cast<Entry*>(node);
+		node = node->next;
+
+		if (entry->_rounds > 0) {
+			entry->_rounds--;
+			continue;
+		}
+		unlink(*entry);
+		link(expired, *entry);
+	}
+
+	while (expired.next != &expired) {
+		Entry* entry = static_cast<Entry*>(expired.next);
+		unlink(*entry);
+		_size--;
+		entry->onExpire();
+	}
+}
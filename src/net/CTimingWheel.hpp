@@ -0,0 +1,88 @@
+/*
+ * CTimingWheel.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CTIMINGWHEEL_HPP_
+#define SRC_NET_CTIMINGWHEEL_HPP_
+
+#include <boost/system/error_code.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+// 哈希时间轮 (每个 io_context 一个, 只在本线程使用).
+// 每秒走一格, 定时项侵入式挂在槽的双向链表上, 增删 O(1), 每格只处理到期槽.
+// 每格刷新 CCoarseClock, 并按时钟补齐被延误的格.
+class CTimingWheel : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	enum { SLOTS = 256 };		// 一圈 256 秒, 超出的用圈数表示
+	enum { TICK_MS = 1000 };
+
+	struct Link
+	{
+		Link() : prev(NULL), next(NULL) {}
+		Link* prev;
+		Link* next;
+	};
+
+	class Entry : public Link
+	{
+	public:
+		Entry() : _rounds(0) {}
+		virtual ~Entry() {}
+		bool scheduled() const { return prev != NULL; }
+		virtual void onExpire() = 0;
+
+	private:
+		friend class CTimingWheel;
+		Entry(const Entry&);
+		Entry& operator=(const Entry&);
+		uint32_t _rounds;
+	};
+
+	// 到期回调 owner 的成员函数
+	template <typename T, void (T::*F)()>
+	class Timer : public Entry
+	{
+	public:
+		explicit Timer(T& owner) : _owner(owner) {}
+		virtual void onExpire() { (_owner.*F)(); }
+
+	private:
+		T& _owner;
+	};
+
+	explicit CTimingWheel(asio::io_context& io);
+	~CTimingWheel();
+
+	uint32_t now() const { return _now; } // 启动以来走过的格数
+	size_t size() const { return _size; }
+	void schedule(Entry& entry, uint32_t ticks);
+	void cancel(Entry& entry);
+
+private:
+	virtual void shutdown();
+	void wait();
+	void onTick(const boost::system::error_code& ec);
+	void advance();
+
+	static void link(Link& head, Link& node);
+	static void unlink(Link& node);
+
+	asio::steady_timer _timer;
+	Link _slots[SLOTS];
+	uint64_t _base_ms;	// 启动时的时钟
+	uint32_t _now;
+	size_t _size;
+};
+
+#endif /* SRC_NET_CTIMINGWHEEL_HPP_ */
@@ -0,0 +1,105 @@
+/*
+ * CTraffic.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CTraffic.hpp"
+#include <sstream>
+#include <algorithm>
+#include "util/util.hpp"
+
+asio::io_context::id CWorkerTraffic::id;
+
+CTrafficTotal::CTrafficTotal()
+: up_bytes(0)
+, up_packs(0)
+, up_batches(0)
+, down_bytes(0)
+, down_packs(0)
+, down_batches(0)
+{
+}
+
+CTrafficTotal& CTrafficTotal::operator+=(const CTraffic& t)
+{
+	up_bytes += t.up_bytes.get();
+	up_packs += t.up_packs.get();
+	up_batches += t.up_batches.get();
+	down_bytes += t.down_bytes.get();
+	down_packs += t.down_packs.get();
+	down_batches += t.down_batches.get();
+	return *this;
+}
+
+CTrafficTotal& CTrafficTotal::operator+=(const CTrafficTotal& t)
+{
+	up_bytes += t.up_bytes;
+	up_packs += t.up_packs;
+	up_batches += t.up_batches;
+	down_bytes += t.down_bytes;
+	down_packs += t.down_packs;
+	down_batches += t.down_batches;
+	return *this;
+}
+
+std::string CTrafficTotal::str() const
+{
+	std::stringstream ss;
+	ss << "TX packets(" << up_packs << "): " << util::formatBytes(up_bytes)
+		<< " | RX packets(" << down_packs << "): " << util::formatBytes(down_bytes)
+		<< " | batch avg(" << (up_batches > 0 ? up_packs / up_batches : 0)
+		<< "/" << (down_batches > 0 ? down_packs / down_batches : 0) << ")";
+	return ss.str();
+}
+
+CSendTotal::CSendTotal()
+: writes(0)
+, msgs(0)
+, bytes(0)
+, peak_depth(0)
+{
+}
+
+CSendTotal& CSendTotal::operator+=(const CSendStats& s)
+{
+	writes += s.writes.get();
+	msgs += s.msgs.get();
+	bytes += s.bytes.get();
+	peak_depth = std::max(peak_depth, s.peak_depth.get());
+	return *this;
+}
+
+std::string CSendTotal::str() const
+{
+	std::stringstream ss;
+	ss << "writes(" << writes << "): " << msgs << " msgs, " << util::formatBytes(bytes)
+		<< " | per write avg(" << (writes > 0 ? msgs / writes : 0)
+		<< " msgs/" << (writes > 0 ? bytes / writes : 0) << "B)"
+		<< " | queue peak: " << peak_depth;
+	return ss.str();
+}
+
+CRecvTotal::CRecvTotal()
+: reads(0)
+, frames(0)
+, bytes(0)
+{
+}
+
+CRecvTotal& CRecvTotal::operator+=(const CRecvStats& s)
+{
+	reads += s.reads.get();
+	frames += s.frames.get();
+	bytes += s.bytes.get();
+	return *this;
+}
+
+std::string CRecvTotal::str() const
+{
+	std::stringstream ss;
+	ss << "reads(" << reads << "): " << frames << " frames, " << util::formatBytes(bytes)
+		<< " | per read avg(" << (reads > 0 ? static_cast<double>(frames) / reads : 0) << " frames)";
+	return ss.str();
+}
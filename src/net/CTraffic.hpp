@@ -0,0 +1,157 @@
+/*
+ * CTraffic.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CTRAFFIC_HPP_
+#define SRC_NET_CTRAFFIC_HPP_
+
+#include <string>
+
+#include <boost/atomic.hpp>
+#include <boost/asio/io_context.hpp>
+
+extern "C"
+{
+#include <stdint.h>
+}
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+// 单写者计数器: 只由所属工作线程写, relaxed 读改写不带 lock 前缀;
+// 其它线程随时可读到近似值.
+class CCounter
+{
+public:
+	CCounter() : _v(0) {}
+	void add(uint64_t n) { _v.store(_v.load(boost::memory_order_relaxed) + n, boost::memory_order_relaxed); }
+	uint64_t get() const { return _v.load(boost::memory_order_relaxed); }
+	void raise(uint64_t n) { if (n > get()) _v.store(n, boost::memory_order_relaxed); }
+
+private:
+	CCounter(const CCounter&);
+	CCounter& operator=(const CCounter&);
+	boost::atomic<uint64_t> _v;
+};
+
+// 双向流量计数, up 为上行(src --> dst)
+struct CTraffic
+{
+	CCounter up_bytes;
+	CCounter up_packs;
+	CCounter up_batches;
+	CCounter down_bytes;
+	CCounter down_packs;
+	CCounter down_batches;
+
+	void count(bool up, uint64_t bytes, uint64_t packs) {
+		if (up) {
+			up_bytes.add(bytes);
+			up_packs.add(packs);
+		}
+		else {
+			down_bytes.add(bytes);
+			down_packs.add(packs);
+		}
+	}
+
+	void batch(bool up) {
+		(up ? up_batches : down_batches).add(1);
+	}
+};
+
+// 按需聚合的快照
+struct CTrafficTotal
+{
+	CTrafficTotal();
+	CTrafficTotal& operator+=(const CTraffic& t);
+	CTrafficTotal& operator+=(const CTrafficTotal& t);
+	std::string str() const;
+
+	uint64_t up_bytes;
+	uint64_t up_packs;
+	uint64_t up_batches;
+	uint64_t down_bytes;
+	uint64_t down_packs;
+	uint64_t down_batches;
+};
+
+// 控制连接发送统计: 每次聚合写 (一次 writev) 的消息数和字节数, 发送队列峰值
+struct CSendStats
+{
+	CCounter writes;
+	CCounter msgs;
+	CCounter bytes;
+	CCounter peak_depth;
+
+	void write(uint64_t n, uint64_t nbytes) {
+		writes.add(1);
+		msgs.add(n);
+		bytes.add(nbytes);
+	}
+};
+
+struct CSendTotal
+{
+	CSendTotal();
+	CSendTotal& operator+=(const CSendStats& s);
+	std::string str() const;
+
+	uint64_t writes;
+	uint64_t msgs;
+	uint64_t bytes;
+	uint64_t peak_depth;
+};
+
+// 控制连接接收统计: 每次读 (一次 recv) 解析出的完整帧数
+struct CRecvStats
+{
+	CCounter reads;
+	CCounter frames;
+	CCounter bytes;
+
+	void read(uint64_t n, uint64_t nbytes) {
+		reads.add(1);
+		frames.add(n);
+		bytes.add(nbytes);
+	}
+};
+
+struct CRecvTotal
+{
+	CRecvTotal();
+	CRecvTotal& operator+=(const CRecvStats& s);
+	std::string str() const;
+
+	uint64_t reads;
+	uint64_t frames;
+	uint64_t bytes;
+};
+
+// 工作线程级全局流量 (每个 io_context 一个, 通道在本线程累加)
+class CWorkerTraffic : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	explicit CWorkerTraffic(asio::io_context& io) : asio::io_context::service(io), _enabled(true) {}
+	void init(bool enabled) { _enabled = enabled; }
+	bool enabled() const { return _enabled; }
+	CTraffic& traffic() { return _traffic; }
+	CSendStats& send() { return _send; }	// 会话收发统计, 不受 enabled 控制
+	CRecvStats& recv() { return _recv; }
+
+private:
+	virtual void shutdown() {}
+
+	bool _enabled;	// 关闭后通道不再计数
+	CTraffic _traffic;
+	CSendStats _send;
+	CRecvStats _recv;
+};
+
+#endif /* SRC_NET_CTRAFFIC_HPP_ */
@@ -0,0 +1,250 @@
+/*
+ * CUdpDemux.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CUdpDemux.hpp"
+#include <boost/bind.hpp>
+#include <boost/asio/post.hpp>
+#include "CChannel.hpp"
+#include "util/CLogger.hpp"
+
+extern "C"
+{
+#include <string.h>
+}
+
+asio::io_context::id CUdpDemux::id;
+
+CUdpDemux::CUdpDemux(asio::io_context& io)
+: asio::io_context::service(io)
+, _io(io)
+, _table(NULL)
+, _mtu(0)
+, _started(false)
+{
+}
+
+CUdpDemux::~CUdpDemux()
+{
+}
+
+void CUdpDemux::shutdown()
+{
+	_started = false;
+
+	boost::system::error_code ignored_ec;
+	for (size_t i = 0; i < _sockets.size(); i++)
+		_sockets[i]->socket.close(ignored_ec);
+
+	// 通道析构会回调 remove, 先摘下再释放
+	Channels channels;
+	channels.swap(_channels);
+	_index.clear();
+	channels.clear();
+}
+
+bool CUdpDemux::init(const std::vector<std::string>& ips, uint32_t sockets, uint32_t mtu)
+{
+	boost::system::error_code ec;
+	for (size_t i = 0; i < ips.size(); i++) {
+		asio::ip::address addr = asio::ip::address::from_string(ips[i], ec);
+		if (ec) {
+			LOG(ERR) << "udp demux invalid ip[" << ips[i] << "]: " << ec.message();
+			continue;
+		}
+
+		for (uint32_t n = 0; n < sockets; n++) {
+			boost::shared_ptr<Socket> s(new Socket(_io));
+			s->socket.open(asio::ip::udp::v4(), ec);
+			if (ec) {
+				LOG(ERR) << "udp demux open socket error: " << ec.message();
+				return false;
+			}
+
+			s->socket.set_option(asio::ip::udp::socket::reuse_address(true));
+			s->socket.bind(asio::ip::udp::endpoint(addr, 0), ec);
+			if (ec) {
+				LOG(ERR) << "udp demux bind [" << addr << "] error: " << ec.message();
+				return false;
+			}
+
+			// 共享 socket 不能为单个通道阻塞, 发送缓冲满时丢弃
+			s->socket.non_blocking(true, ec);
+			if (ec) {
+				LOG(ERR) << "udp demux set non-blocking error: " << ec.message();
+				return false;
+			}
+
+			s->local_ep = s->socket.local_endpoint(ec);
+			_sockets.push_back(s);
+		}
+	}
+
+	if (_sockets.empty())
+		return false;
+
+	_mtu = mtu;
+	_started = true;
+	for (size_t i = 0; i < _sockets.size(); i++) {
+		LOG(INFO) << "udp demux listen on [" << _sockets[i]->local_ep << "]";
+		asio::spawn(_io, boost::bind(&CUdpDemux::receiver, this, i, boost::placeholders::_1));
+	}
+	return true;
+}
+
+int CUdpDemux::pick(const asio::ip::address& addr, uint32_t chann_id)
+{
+	// 初始化后 _sockets 只读, 可跨线程调用
+	std::vector<int> group;
+	for (size_t i = 0; i < _sockets.size(); i++) {
+		if (_sockets[i]->local_ep.address() == addr)
+			group.push_back(i);
+	}
+
+	if (group.empty())
+		return -1;
+	return group[chann_id % group.size()];
+}
+
+void CUdpDemux::add(const boost::shared_ptr<CChannel>& chann)
+{
+	if (!_started)
+		return;
+
+	if (!chann->table()) {
+		LOG(ERR) << "udp demux channel[" << chann->id() << "] not registered";
+		return;
+	}
+
+	_table = chann->table();
+	chann->_demux_pos = _channels.size();
+	_channels.push_back(chann);
+	LOGF(TRACE) << "udp demux add channel[" << chann->id() << "], total: " << _channels.size();
+}
+
+void CUdpDemux::remove(CChannel* chann)
+{
+	if (!holds(chann))
+		return;
+
+	size_t pos = chann->_demux_pos;
+	unbind(chann, chann->_src_end._shared, chann->_src_end._bound, chann->_src_end._remote_ep);
+	unbind(chann, chann->_dst_end._shared, chann->_dst_end._bound, chann->_dst_end._remote_ep);
+
+	// remove 可能在通道自身的调用栈里, 延后释放引用
+	asio::post(_io, boost::bind(&CUdpDemux::release, _channels[pos]));
+	_channels[pos] = _channels.back();
+	_channels[pos]->_demux_pos = pos;
+	_channels.pop_back();
+}
+
+bool CUdpDemux::holds(CChannel* chann) const
+{
+	size_t pos = chann->_demux_pos;
+	return pos < _channels.size() && _channels[pos].get() == chann;
+}
+
+void CUdpDemux::unbind(CChannel* chann, int sock, bool bound, const asio::ip::udp::endpoint& ep)
+{
+	if (!bound)
+		return;
+
+	Index::iterator it = _index.find(Key(sock, ep));
+	if (it != _index.end() && it->second.chann == chann)
+		_index.erase(it);
+}
+
+bool CUdpDemux::bind(size_t idx, const asio::ip::udp::endpoint& ep, size_t bytes, Binding& binding)
+{
+	Socket& s = *_sockets[idx];
+	if (bytes < sizeof(uint32_t)) {
+		LOG_LIMIT(s.recv_log, DEBUG) << "udp demux[" << s.local_ep << "] drop short packet from [" << ep << "]";
+		return false;
+	}
+
+	uint32_t chann_id = 0;
+	memcpy(&chann_id, &s.buf[0], sizeof(chann_id));
+
+	// 通道表里的通道可能属于别的线程, 只认本分发器持有的
+	boost::shared_ptr<CChannel> chann = _table ? _table->get(chann_id) : boost::shared_ptr<CChannel>();
+	if (!chann || !holds(chann.get())) {
+		LOG_LIMIT(s.recv_log, DEBUG) << "udp demux[" << s.local_ep << "] drop from [" << ep << "], unknown channel[" << chann_id << "]";
+		return false;
+	}
+
+	asio::ip::udp::endpoint prev;
+	binding.chann = chann.get();
+	if (!binding.chann->demuxBind(idx, ep, &s.buf[0], bytes, binding.up, prev))
+		return false;
+
+	if (prev == ep)
+		return true;
+
+	// NAT 重映射换了端口, 摘下旧地址; 同一地址可能残留已换通道的旧登记, 直接覆盖
+	unbind(binding.chann, idx, prev.port() != 0, prev);
+	_index[Key(idx, ep)] = binding;
+	LOG(INFO) << "udp demux[" << s.local_ep << "] bind [" << ep << "] to channel["
+			<< chann_id << "] " << (binding.up ? "src" : "dst");
+	return true;
+}
+
+void CUdpDemux::receiver(size_t idx, asio::yield_context yield)
+{
+	Socket& s = *_sockets[idx];
+	boost::system::error_code ec;
+	asio::ip::udp::endpoint from;
+	asio::ip::udp::endpoint to;
+	Binding binding;
+	size_t bytes = 0;
+	int sock = -1;
+
+	// 在工作线程上分配, 内存落在该线程的 NUMA 节点
+	s.buf.resize(_mtu);
+
+	while (_started) {
+		bytes = s.socket.async_receive_from(asio::buffer(s.buf), from, yield[ec]);
+		if (ec) {
+			if (!s.socket.is_open())
+				break;
+
+			LOG_LIMIT(s.recv_log, ERR) << "udp demux[" << s.local_ep << "] receive error: " << ec.message();
+			continue;
+		}
+
+		// 已认证的端按地址查表; 未登记或认证阶段的包带通道号前缀, 优先按前缀路由
+		Index::iterator it = _index.find(Key(idx, from));
+		if (it == _index.end()) {
+			if (!bind(idx, from, bytes, binding))
+				continue;
+		}
+		else if ((it->second.up ? it->second.chann->_src_end : it->second.chann->_dst_end)._opened
+				|| !bind(idx, from, bytes, binding)) {
+			binding = it->second;
+		}
+
+		// 非阻塞发送: 不让出协程, 通道指针在本轮内始终有效
+		CChannel::DemuxAction act = binding.chann->demuxRecv(binding.up, from, &s.buf[0], bytes, sock, to);
+		if (act == CChannel::DEMUX_DROP)
+			continue;
+
+		Socket& out = *_sockets[sock];
+		bytes = out.socket.send_to(asio::buffer(&s.buf[0], bytes), to, 0, ec);
+		if (ec == asio::error::would_block) {
+			out.send_drops++;
+			LOG_LIMIT(out.send_log, WARNING) << "udp demux[" << out.local_ep << "] send buffer full, dropped: " << out.send_drops;
+			continue;
+		}
+
+		if (ec) {
+			LOG_LIMIT(out.send_log, ERR) << "udp demux[" << out.local_ep << "] send to [" << to << "] error: " << ec.message();
+			continue;
+		}
+
+		if (act == CChannel::DEMUX_FORWARD)
+			binding.chann->demuxSent(binding.up, bytes);
+	}
+	LOGF(TRACE) << "udp demux[" << s.local_ep << "] receiver exit!";
+}
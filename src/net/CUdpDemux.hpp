@@ -0,0 +1,109 @@
+/*
+ * CUdpDemux.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CUDPDEMUX_HPP_
+#define SRC_NET_CUDPDEMUX_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/unordered/unordered_map.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/spawn.hpp>
+
+#include "util/CLogLimiter.hpp"
+#include "util/CSlabTable.hpp"
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+class CChannel;
+
+// 共享端口 UDP 分发 (每个 io_context 一个).
+// 每个本机IP绑定少量固定 socket, 所有通道共用; 数据包按 (socket, 远端地址) 查表分发到通道.
+// 认证阶段的包须以通道号(4字节)为前缀, 按前缀路由并完成绑定; 同IP换端口(NAT重映射)时凭前缀重新绑定.
+class CUdpDemux : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	explicit CUdpDemux(asio::io_context& io);
+	~CUdpDemux();
+
+	bool init(const std::vector<std::string>& ips, uint32_t sockets, uint32_t mtu);
+	bool available() const { return !_sockets.empty(); }
+
+	int pick(const asio::ip::address& addr, uint32_t chann_id);
+	asio::ip::udp::endpoint localEndpoint(int sock) { return _sockets[sock]->local_ep; }
+
+	void add(const boost::shared_ptr<CChannel>& chann);
+	void remove(CChannel* chann);
+
+private:
+	struct Socket
+	{
+		explicit Socket(asio::io_context& io) : socket(io), send_drops(0) {}
+		asio::ip::udp::socket socket;
+		asio::ip::udp::endpoint local_ep;
+		std::vector<char> buf;
+		CLogLimiter recv_log;	// 绑定/接收错误
+		CLogLimiter send_log;
+		uint64_t send_drops;	// 发送缓冲满丢弃的数据报
+	};
+
+	struct Binding
+	{
+		CChannel* chann;
+		bool up;
+	};
+
+	// 同一远端可经不同共享 socket 对应不同通道
+	struct Key
+	{
+		Key(size_t s, const asio::ip::udp::endpoint& e) : sock(s), ep(e) {}
+		bool operator==(const Key& other) const { return sock == other.sock && ep == other.ep; }
+		size_t sock;
+		asio::ip::udp::endpoint ep;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const {
+			uint64_t v = (static_cast<uint64_t>(key.ep.address().to_v4().to_uint()) << 16) | key.ep.port();
+			size_t seed = key.sock;
+			boost::hash_combine(seed, v);
+			return seed;
+		}
+	};
+
+	typedef boost::unordered_map<Key, Binding, KeyHash> Index;
+	typedef std::vector<boost::shared_ptr<CChannel> > Channels;
+
+	virtual void shutdown();
+	void receiver(size_t idx, asio::yield_context yield);
+	bool bind(size_t idx, const asio::ip::udp::endpoint& ep, size_t bytes, Binding& binding);
+	void unbind(CChannel* chann, int sock, bool bound, const asio::ip::udp::endpoint& ep);
+	bool holds(CChannel* chann) const;
+	// 空处理函数: 参数只为让投递的 handler 持有通道引用, handler 执行完后通道才析构
+	static void release(const boost::shared_ptr<CChannel>&) {}
+
+private:
+	asio::io_context& _io;
+	std::vector<boost::shared_ptr<Socket> > _sockets;
+	Index _index;
+	Channels _channels;		// 持有本线程的共享端口通道, 按前缀查找走通道表
+	CSlabTable<CChannel>* _table;
+	uint32_t _mtu;
+	bool _started;
+};
+
+#endif /* SRC_NET_CUDPDEMUX_HPP_ */
@@ -0,0 +1,631 @@
+/*
+ * CUringRelay.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CUringRelay.hpp"
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/asio/placeholders.hpp>
+#include "CChannel.hpp"
+#include "util/CLogger.hpp"
+
+extern "C"
+{
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+}
+
+asio::io_context::id CUringRelay::id;
+
+CUringRelay::CUringRelay(asio::io_context& io)
+: asio::io_context::service(io)
+#if defined(NAT_HAS_IO_URING)
+, _ring_ptr(MAP_FAILED)
+, _ring_len(0)
+, _sqes(NULL)
+, _sqes_len(0)
+, _sq_entries(0)
+, _sq_local_tail(0)
+, _sq_head(NULL)
+, _sq_tail(NULL)
+, _sq_mask(NULL)
+, _sq_array(NULL)
+, _sq_flags(NULL)
+, _cq_head(NULL)
+, _cq_tail(NULL)
+, _cq_mask(NULL)
+, _cqes(NULL)
+, _br(NULL)
+, _br_len(0)
+, _br_tail(0)
+, _bufs(NULL)
+, _bufs_len(0)
+, _buf_size(0)
+, _buf_num(0)
+#endif
+, _ring_fd(-1)
+, _event_fd(-1)
+, _event(io)
+{
+}
+
+CUringRelay::~CUringRelay()
+{
+	release();
+}
+
+void CUringRelay::shutdown()
+{
+	release();
+}
+
+#if !defined(NAT_HAS_IO_URING)
+
+bool CUringRelay::init(uint32_t buffers, uint32_t mtu)
+{
+	LOG(WARNING) << "uring relay not compiled in, fallback to asio relay.";
+	return false;
+}
+
+int CUringRelay::attach(const boost::shared_ptr<CChannel>& chann, bool up, int in_fd, int out_fd)
+{
+	return -1;
+}
+
+void CUringRelay::detach(int slot)
+{
+}
+
+void CUringRelay::release()
+{
+}
+
+void CUringRelay::wait()
+{
+}
+
+void CUringRelay::onEvent(const boost::system::error_code& ec)
+{
+}
+
+#else
+
+namespace {
+	// multishot recvmsg 需要 6.0 以上内核
+	bool kernelSupported()
+	{
+		struct utsname un;
+		if (uname(&un) != 0)
+			return false;
+
+		int major = 0, minor = 0;
+		if (sscanf(un.release, "%d.%d", &major, &minor) != 2)
+			return false;
+		return major >= 6;
+	}
+
+	int uringSetup(unsigned entries, struct io_uring_params* p)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+	}
+
+	int uringEnter(int fd, unsigned to_submit, unsigned flags = 0)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, 0, flags, NULL, 0));
+	}
+
+	int uringRegister(int fd, unsigned op, void* arg, unsigned nr)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_register, fd, op, arg, nr));
+	}
+}
+
+bool CUringRelay::init(uint32_t buffers, uint32_t mtu)
+{
+	if (available())
+		return true;
+
+	if (!kernelSupported()) {
+		LOG(WARNING) << "uring relay needs linux >= 6.0, fallback to asio relay.";
+		return false;
+	}
+
+	// 缓冲环大小必须是 2 的幂, 且不超过 32768
+	_buf_num = 1;
+	while (_buf_num * 2 <= std::min<uint32_t>(buffers, 32768))
+		_buf_num *= 2;
+	_buf_size = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) + mtu;
+
+	struct io_uring_params params;
+	bzero(&params, sizeof(params));
+	_ring_fd = uringSetup(_buf_num, &params);
+	if (_ring_fd < 0) {
+		LOG(WARNING) << "uring relay setup error: " << strerror(errno) << ", fallback to asio relay.";
+		_ring_fd = -1;
+		return false;
+	}
+
+	// NODROP: CQ 满时内核把完成事件暂存在溢出链表, 不会丢掉 multishot 的终止事件
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+		LOG(WARNING) << "uring relay kernel lacks single mmap or nodrop, fallback to asio relay.";
+		release();
+		return false;
+	}
+
+	_ring_len = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+			params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	_ring_ptr = mmap(NULL, _ring_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+	_sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	void* sqes = mmap(NULL, _sqes_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+	if (_ring_ptr == MAP_FAILED || sqes == MAP_FAILED) {
+		LOG(ERR) << "uring relay mmap ring error: " << strerror(errno);
+		if (sqes != MAP_FAILED)
+			munmap(sqes, _sqes_len);
+		release();
+		return false;
+	}
+	_sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+	char* ring = static_cast<char*>(_ring_ptr);
+	_sq_entries = params.sq_entries;
+	_sq_head = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+	_sq_tail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+	_sq_mask = reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+	_sq_array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+	_sq_flags = reinterpret_cast<unsigned*>(ring + params.sq_off.flags);
+	_sq_local_tail = *_sq_tail;
+	_cq_head = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+	_cq_tail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+	_cq_mask = reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<struct io_uring_cqe*>(ring + params.cq_off.cqes);
+
+	// 注册缓冲环, 接收时由内核挑选缓冲
+	_br_len = _buf_num * sizeof(struct io_uring_buf);
+	void* br = mmap(NULL, _br_len, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	_bufs_len = static_cast<size_t>(_buf_num) * _buf_size;
+	void* bufs = mmap(NULL, _bufs_len, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (br == MAP_FAILED || bufs == MAP_FAILED) {
+		LOG(ERR) << "uring relay mmap buffers error: " << strerror(errno);
+		if (br != MAP_FAILED)
+			munmap(br, _br_len);
+		if (bufs != MAP_FAILED)
+			munmap(bufs, _bufs_len);
+		release();
+		return false;
+	}
+	_br = static_cast<struct io_uring_buf_ring*>(br);
+	_bufs = static_cast<char*>(bufs);
+
+	struct io_uring_buf_reg reg;
+	bzero(&reg, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<uint64_t>(_br);
+	reg.ring_entries = _buf_num;
+	reg.bgid = BUF_GROUP;
+	if (uringRegister(_ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		LOG(WARNING) << "uring relay register buffer ring error: " << strerror(errno)
+				<< ", fallback to asio relay.";
+		release();
+		return false;
+	}
+
+	_smsgs.resize(_buf_num);
+	_siovs.resize(_buf_num);
+	_saddrs.resize(_buf_num);
+	_br_tail = 0;
+	for (uint32_t i = 0; i < _buf_num; i++)
+		recycle(static_cast<uint16_t>(i));
+
+	_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_event_fd < 0 || uringRegister(_ring_fd, IORING_REGISTER_EVENTFD, &_event_fd, 1) < 0) {
+		LOG(ERR) << "uring relay register eventfd error: " << strerror(errno);
+		release();
+		return false;
+	}
+
+	boost::system::error_code ec;
+	_event.assign(_event_fd, ec);
+	if (ec) {
+		LOG(ERR) << "uring relay assign eventfd error: " << ec.message();
+		release();
+		return false;
+	}
+
+	wait();
+	LOG(INFO) << "uring relay ready. buffers: " << _buf_num << " x " << _buf_size << "B";
+	return true;
+}
+
+void CUringRelay::release()
+{
+	// 描述符交给 _event 后随它关闭; 登记或 assign 失败时还没交出去, 自己关
+	boost::system::error_code ignored_ec;
+	if (_event.is_open())
+		_event.close(ignored_ec);
+	else if (_event_fd >= 0)
+		close(_event_fd);
+	_event_fd = -1;
+
+	// 元素析构可能放掉最后一个 CChannel 引用, ~CChannel 会回调 detach();
+	// 先把表换出并清空槽位列表, 让 detach() 看到空表直接返回
+	std::deque<Stream> streams;
+	streams.swap(_streams);
+	_free_slots.clear();
+	_starved_slots.clear();
+	_cancel_slots.clear();
+	streams.clear();
+
+	if (_bufs) {
+		munmap(_bufs, _bufs_len);
+		_bufs = NULL;
+	}
+	if (_br) {
+		munmap(_br, _br_len);
+		_br = NULL;
+	}
+	if (_sqes) {
+		munmap(_sqes, _sqes_len);
+		_sqes = NULL;
+	}
+	if (_ring_ptr != MAP_FAILED) {
+		munmap(_ring_ptr, _ring_len);
+		_ring_ptr = MAP_FAILED;
+	}
+	if (_ring_fd >= 0) {
+		close(_ring_fd);
+		_ring_fd = -1;
+	}
+}
+
+void CUringRelay::wait()
+{
+	_event.async_wait(asio::posix::stream_descriptor::wait_read,
+			boost::bind(&CUringRelay::onEvent, this, asio::placeholders::error));
+}
+
+void CUringRelay::onEvent(const boost::system::error_code& ec)
+{
+	if (ec) {
+		if (ec != asio::error::operation_aborted)
+			LOG(ERR) << "uring relay wait error: " << ec.message();
+		return;
+	}
+
+	uint64_t cnt = 0;
+	if (read(_event_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+		LOG(ERR) << "uring relay read eventfd error: " << strerror(errno);
+
+	reap();
+	wait();
+}
+
+int CUringRelay::attach(const boost::shared_ptr<CChannel>& chann, bool up, int in_fd, int out_fd)
+{
+	if (!available())
+		return -1;
+
+	uint32_t slot = 0;
+	if (_free_slots.empty()) {
+		slot = static_cast<uint32_t>(_streams.size());
+		_streams.push_back(Stream());
+		_streams.back().gen = 0;
+	}
+	else {
+		slot = _free_slots.back();
+		_free_slots.pop_back();
+	}
+
+	Stream& s = _streams[slot];
+	s.chann = chann;
+	s.in_fd = in_fd;
+	s.out_fd = out_fd;
+	s.up = up;
+	s.active = true;
+	s.armed = false;
+	s.starved = false;
+	s.inflight = 0;
+	bzero(&s.msg, sizeof(s.msg));
+	s.msg.msg_namelen = sizeof(struct sockaddr_in);
+
+	if (!arm(slot)) {
+		s.active = false;
+		tryFree(slot);
+		return -1;
+	}
+	submit();
+	return static_cast<int>(slot);
+}
+
+void CUringRelay::detach(int slot)
+{
+	if (slot < 0 || static_cast<size_t>(slot) >= _streams.size())
+		return;
+
+	Stream& s = _streams[slot];
+	if (!s.active)
+		return;
+
+	s.active = false;
+	if (s.armed) {
+		cancel(slot);
+		submit();
+	}
+	tryFree(slot);
+}
+
+struct io_uring_sqe* CUringRelay::getSqe()
+{
+	unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+	if (_sq_local_tail - head >= _sq_entries) {
+		submit();
+		head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+		if (_sq_local_tail - head >= _sq_entries)
+			return NULL;
+	}
+
+	unsigned idx = _sq_local_tail & *_sq_mask;
+	struct io_uring_sqe* sqe = &_sqes[idx];
+	bzero(sqe, sizeof(*sqe));
+	_sq_array[idx] = idx;
+	_sq_local_tail++;
+	return sqe;
+}
+
+void CUringRelay::submit()
+{
+	unsigned to_submit = _sq_local_tail - *_sq_tail;
+	if (to_submit == 0)
+		return;
+
+	__atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+	if (uringEnter(_ring_fd, to_submit) < 0)
+		LOG(ERR) << "uring relay submit " << to_submit << " error: " << strerror(errno);
+}
+
+void CUringRelay::reap()
+{
+	unsigned head = *_cq_head;
+	unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+	for (;;) {
+		while (head != tail) {
+			handle(_cqes[head & *_cq_mask]);
+			head++;
+		}
+		__atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+
+		// 一批转发统一提交, 之前 SQ 满没提交上的取消趁 SQ 腾空补上
+		submit();
+		retryCancels();
+
+		// CQ 溢出时内核暂存的完成事件要主动取回, 否则 multishot 的终止事件一直收不到
+		flushOverflow();
+		tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+		if (head == tail)
+			break;
+	}
+}
+
+void CUringRelay::flushOverflow()
+{
+	if (!(__atomic_load_n(_sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW))
+		return;
+
+	LOG_LIMIT(_sq_log, WARNING) << "uring relay completion queue overflow, flushing.";
+	if (uringEnter(_ring_fd, 0, IORING_ENTER_GETEVENTS) < 0 && errno != EBUSY && errno != EINTR)
+		LOG(ERR) << "uring relay flush overflow error: " << strerror(errno);
+}
+
+void CUringRelay::handle(const struct io_uring_cqe& cqe)
+{
+	uint8_t op = static_cast<uint8_t>(cqe.user_data & 0xFF);
+	uint16_t bid = static_cast<uint16_t>((cqe.user_data >> 8) & 0xFFFF);
+	uint32_t slot = static_cast<uint32_t>((cqe.user_data >> 24) & 0xFFFFFF);
+	uint16_t gen = static_cast<uint16_t>(cqe.user_data >> 48);
+
+	if (slot >= _streams.size() || _streams[slot].gen != gen) {
+		if (op == OP_RECV && (cqe.flags & IORING_CQE_F_BUFFER))
+			recycle(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+		return;
+	}
+
+	switch (op) {
+	case OP_RECV:
+		onRecv(slot, cqe);
+		break;
+	case OP_SEND:
+		onSend(slot, bid, cqe);
+		break;
+	default:
+		break;
+	}
+}
+
+void CUringRelay::onRecv(uint32_t slot, const struct io_uring_cqe& cqe)
+{
+	Stream& s = _streams[slot];
+	if (!(cqe.flags & IORING_CQE_F_MORE))
+		s.armed = false;
+
+	if (cqe.res < 0) {
+		if (cqe.res == -ENOBUFS) {
+			if (s.active && !s.starved) {
+				s.starved = true;
+				_starved_slots.push_back(slot);
+			}
+		}
+		else if (cqe.res != -ECANCELED) {
+			LOG_LIMIT(s.log, ERR) << "uring relay stream[" << slot << "] receive error: "
+					<< boost::system::error_code(-cqe.res, boost::system::system_category()).message();
+			if (cqe.res == -EBADF || cqe.res == -ENOTSOCK)
+				s.active = false;
+		}
+
+		if (s.active && !s.armed && !s.starved)
+			arm(slot);
+		tryFree(slot);
+		return;
+	}
+
+	if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+		if (s.active && !s.armed)
+			arm(slot);
+		return;
+	}
+
+	uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+	char* buf = _bufs + static_cast<size_t>(bid) * _buf_size;
+	const struct io_uring_recvmsg_out* out = reinterpret_cast<const struct io_uring_recvmsg_out*>(buf);
+	const struct sockaddr_in* from = reinterpret_cast<const struct sockaddr_in*>(buf + sizeof(*out));
+	char* payload = buf + sizeof(*out) + s.msg.msg_namelen + s.msg.msg_controllen;
+
+	bool forward = s.active && !(out->flags & MSG_TRUNC);
+	socklen_t tolen = 0;
+	if (forward)
+		forward = s.chann->uringRecv(s.up, *from, out->payloadlen, _saddrs[bid], tolen);
+
+	struct io_uring_sqe* sqe = forward ? getSqe() : NULL;
+	if (!sqe) {
+		recycle(bid);
+	}
+	else {
+		struct msghdr& msg = _smsgs[bid];
+		bzero(&msg, sizeof(msg));
+		_siovs[bid].iov_base = payload;
+		_siovs[bid].iov_len = out->payloadlen;
+		msg.msg_name = tolen > 0 ? &_saddrs[bid] : NULL;
+		msg.msg_namelen = tolen;
+		msg.msg_iov = &_siovs[bid];
+		msg.msg_iovlen = 1;
+
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->fd = s.out_fd;
+		sqe->addr = reinterpret_cast<uint64_t>(&msg);
+		sqe->len = 1;
+		sqe->user_data = pack(slot, s.gen, bid, OP_SEND);
+		s.inflight++;
+	}
+
+	if (s.active && !s.armed && !s.starved)
+		arm(slot);
+}
+
+void CUringRelay::onSend(uint32_t slot, uint16_t bid, const struct io_uring_cqe& cqe)
+{
+	Stream& s = _streams[slot];
+	s.inflight--;
+	recycle(bid);
+
+	if (s.active)
+		s.chann->uringSent(s.up, cqe.res);
+	tryFree(slot);
+}
+
+bool CUringRelay::arm(uint32_t slot)
+{
+	Stream& s = _streams[slot];
+	struct io_uring_sqe* sqe = getSqe();
+	if (!sqe) {
+		LOG_LIMIT(_sq_log, ERR) << "uring relay stream[" << slot << "] submission queue full.";
+		return false;
+	}
+
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = s.in_fd;
+	sqe->addr = reinterpret_cast<uint64_t>(&s.msg);
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BUF_GROUP;
+	sqe->user_data = pack(slot, s.gen, 0, OP_RECV);
+	s.armed = true;
+	return true;
+}
+
+void CUringRelay::cancel(uint32_t slot)
+{
+	// SQ 满 (getSqe 已先提交过一次) 时记下, 下一批完成事件后重试;
+	// 取消不提交, 接收一直在途, 槽位和通道就永远释放不了
+	if (!prepCancel(slot)) {
+		LOG_LIMIT(_sq_log, WARNING) << "uring relay stream[" << slot << "] cancel deferred, submission queue full.";
+		_cancel_slots.push_back(std::make_pair(slot, _streams[slot].gen));
+	}
+}
+
+bool CUringRelay::prepCancel(uint32_t slot)
+{
+	Stream& s = _streams[slot];
+	struct io_uring_sqe* sqe = getSqe();
+	if (!sqe)
+		return false;
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = pack(slot, s.gen, 0, OP_RECV);
+	sqe->user_data = pack(slot, s.gen, 0, OP_CANCEL);
+	return true;
+}
+
+void CUringRelay::retryCancels()
+{
+	if (_cancel_slots.empty())
+		return;
+
+	std::vector<std::pair<uint32_t, uint16_t> > pending;
+	pending.swap(_cancel_slots);
+	for (size_t i = 0; i < pending.size(); i++) {
+		uint32_t slot = pending[i].first;
+		Stream& s = _streams[slot];
+		// 期间接收已自行结束或槽位已复用, 不用再取消
+		if (s.gen != pending[i].second || s.active || !s.armed)
+			continue;
+
+		if (!prepCancel(slot))
+			_cancel_slots.push_back(pending[i]);
+	}
+	submit();
+}
+
+void CUringRelay::recycle(uint16_t bid)
+{
+	struct io_uring_buf* buf = &_br->bufs[_br_tail & (_buf_num - 1)];
+	buf->addr = reinterpret_cast<uint64_t>(_bufs + static_cast<size_t>(bid) * _buf_size);
+	buf->len = _buf_size;
+	buf->bid = bid;
+	_br_tail++;
+	__atomic_store_n(&_br->tail, _br_tail, __ATOMIC_RELEASE);
+
+	while (!_starved_slots.empty()) {
+		uint32_t slot = _starved_slots.back();
+		_starved_slots.pop_back();
+
+		Stream& s = _streams[slot];
+		s.starved = false;
+		if (s.active && !s.armed)
+			arm(slot);
+		tryFree(slot);
+	}
+}
+
+void CUringRelay::tryFree(uint32_t slot)
+{
+	Stream& s = _streams[slot];
+	if (s.active || s.armed || s.starved || s.inflight > 0 || !s.chann)
+		return;
+
+	s.gen++;
+	_free_slots.push_back(slot);
+	s.chann.reset();
+}
+
+#endif
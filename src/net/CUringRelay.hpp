@@ -0,0 +1,147 @@
+/*
+ * CUringRelay.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_NET_CURINGRELAY_HPP_
+#define SRC_NET_CURINGRELAY_HPP_
+
+#include <deque>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include "util/CLogLimiter.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define NAT_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+extern "C"
+{
+#include <sys/socket.h>
+#include <netinet/in.h>
+}
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+class CChannel;
+
+// io_uring UDP 中继 (每个 io_context 一个).
+// 通道认证后把两端 socket 交给它: multishot recvmsg 从注册的缓冲环取缓冲,
+// 收到即提交 sendmsg 转发, 一批完成事件只经 eventfd 唤醒 io_context 一次.
+class CUringRelay : public asio::io_context::service
+{
+public:
+	static asio::io_context::id id;
+
+	explicit CUringRelay(asio::io_context& io);
+	~CUringRelay();
+
+	bool init(uint32_t buffers, uint32_t mtu);
+	bool available() const { return _ring_fd >= 0; }
+
+	int attach(const boost::shared_ptr<CChannel>& chann, bool up, int in_fd, int out_fd);
+	void detach(int slot);
+
+private:
+	virtual void shutdown();
+	void release();
+	void wait();
+	void onEvent(const boost::system::error_code& ec);
+
+#if defined(NAT_HAS_IO_URING)
+	enum { OP_RECV = 0, OP_SEND = 1, OP_CANCEL = 2 };
+	enum { BUF_GROUP = 1 };
+
+	struct Stream
+	{
+		boost::shared_ptr<CChannel> chann;
+		int in_fd;
+		int out_fd;
+		bool up;
+		bool active;	// 通道仍在中继
+		bool armed; 	// multishot 接收在途
+		bool starved;	// 缓冲耗尽, 等待回收后重新接收
+		uint16_t gen;
+		uint32_t inflight; // 在途发送数
+		struct msghdr msg;
+		CLogLimiter log;
+	};
+
+	static uint64_t pack(uint32_t slot, uint16_t gen, uint16_t bid, uint8_t op) {
+		return (static_cast<uint64_t>(gen) << 48)
+				| (static_cast<uint64_t>(slot & 0xFFFFFF) << 24)
+				| (static_cast<uint64_t>(bid) << 8)
+				| op;
+	}
+
+	struct io_uring_sqe* getSqe();
+	void submit();
+	void reap();
+	void handle(const struct io_uring_cqe& cqe);
+	void onRecv(uint32_t slot, const struct io_uring_cqe& cqe);
+	void onSend(uint32_t slot, uint16_t bid, const struct io_uring_cqe& cqe);
+	bool arm(uint32_t slot);
+	void cancel(uint32_t slot);
+	bool prepCancel(uint32_t slot);
+	void retryCancels();
+	void flushOverflow();
+	void recycle(uint16_t bid);
+	void tryFree(uint32_t slot);
+
+	void*		_ring_ptr;
+	size_t		_ring_len;
+	struct io_uring_sqe* _sqes;
+	size_t		_sqes_len;
+	unsigned	_sq_entries;
+	unsigned	_sq_local_tail;
+	unsigned*	_sq_head;
+	unsigned*	_sq_tail;
+	unsigned*	_sq_mask;
+	unsigned*	_sq_array;
+	unsigned*	_sq_flags;
+	unsigned*	_cq_head;
+	unsigned*	_cq_tail;
+	unsigned*	_cq_mask;
+	struct io_uring_cqe* _cqes;
+
+	struct io_uring_buf_ring* _br;
+	size_t		_br_len;
+	uint16_t	_br_tail;
+	char*		_bufs;
+	size_t		_bufs_len;
+	uint32_t	_buf_size;
+	uint32_t	_buf_num;
+
+	std::vector<struct msghdr> _smsgs;
+	std::vector<struct iovec> _siovs;
+	std::vector<struct sockaddr_in> _saddrs;
+
+	std::deque<Stream> _streams;
+	std::vector<uint32_t> _free_slots;
+	std::vector<uint32_t> _starved_slots;
+	std::vector<std::pair<uint32_t, uint16_t> > _cancel_slots; // SQ 满时未能提交的取消 (槽位, 代数)
+	CLogLimiter _sq_log;
+#endif
+
+	int _ring_fd;
+	int _event_fd;
+	asio::posix::stream_descriptor _event;
+};
+
+#endif /* SRC_NET_CURINGRELAY_HPP_ */
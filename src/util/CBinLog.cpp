@@ -0,0 +1,332 @@
+/*
+ * CBinLog.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CBinLog.hpp"
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include "util.hpp"
+
+extern "C"
+{
+#include <ctype.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+}
+
+boost::atomic<bool> CBinLog::_enabled(false);
+std::string CBinLog::_dir;
+std::string CBinLog::_prefix;
+std::string CBinLog::_path;
+size_t CBinLog::_file_size = 0;
+size_t CBinLog::_max_size = 0;
+uint64_t CBinLog::_epoch_us = 0;
+uint32_t CBinLog::_seq = 0;
+CBinLog::Segment CBinLog::_slots[2];
+boost::atomic<CBinLog::Segment*> CBinLog::_seg(NULL);
+boost::mutex CBinLog::_mutex;
+
+static uint64_t nowUs()
+{
+	struct timespec ts;
+	::clock_gettime(CLOCK_REALTIME, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool CBinLog::init(const std::string& proc_name, const std::string& dir, size_t file_size, size_t max_size)
+{
+	boost::mutex::scoped_lock lk(_mutex);
+	_dir = dir;
+	_prefix = proc_name + "_";
+	std::stringstream ss;
+	ss << dir << "/" << _prefix << ::getpid();
+	_path = ss.str();
+	_file_size = std::max<size_t>(file_size, MB);
+	_max_size = std::max<size_t>(max_size, 2 * _file_size);	// 至少容得下滚动时同时打开的两个
+	_epoch_us = nowUs();
+
+	for (size_t i = 0; i < 2; i++)
+		_slots[i].fd = -1;
+
+	if (!open(&_slots[0])) {
+		LOG(ERR) << "binary log disabled, channel logs fall back to text.";
+		return false;
+	}
+
+	_seg.store(&_slots[0]);
+	_enabled = true;
+	return true;
+}
+
+void CBinLog::finit()
+{
+	boost::mutex::scoped_lock lk(_mutex);
+	_enabled = false;
+
+	Segment* seg = _seg.exchange(NULL);
+	if (seg) {
+		drain(seg);
+		close(seg);
+	}
+}
+
+bool CBinLog::open(Segment* seg)
+{
+	char ts[32] = "";
+	time_t now = ::time(NULL);
+	struct tm tm;
+	::strftime(ts, sizeof(ts), "%Y%m%d_%H%M%S", ::localtime_r(&now, &tm));
+
+	std::stringstream name;
+	name << _path << "_" << ts << "_" << _seq++ << ".blog";
+
+	retain();
+
+	int fd = ::open(name.str().c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		LOG(ERR) << "binary log open [" << name.str() << "] error: " << strerror(errno);
+		return false;
+	}
+
+	// 整个文件先分配好: 磁盘满时在这里失败, 而不是写映射时 SIGBUS
+	int err = ::posix_fallocate(fd, 0, _file_size);
+	if (err != 0) {
+		LOG(ERR) << "binary log allocate " << _file_size << "B [" << name.str() << "] error: " << strerror(err);
+		::close(fd);
+		::unlink(name.str().c_str());
+		return false;
+	}
+
+	void* base = ::mmap(NULL, _file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		LOG(ERR) << "binary log mmap [" << name.str() << "] error: " << strerror(errno);
+		::close(fd);
+		::unlink(name.str().c_str());
+		return false;
+	}
+
+	binlog::FileHeader hdr;
+	memcpy(hdr.magic, binlog::MAGIC, sizeof(hdr.magic));
+	hdr.version = binlog::VERSION;
+	hdr.pid = ::getpid();
+	hdr.start_us = _epoch_us;
+	memcpy(base, &hdr, sizeof(hdr));
+
+	seg->fd = fd;
+	seg->name = name.str();
+	seg->base = static_cast<char*>(base);
+	seg->size = _file_size;
+	seg->pos = sizeof(hdr);
+
+	LOG(INFO) << "binary log open [" << name.str() << "]";
+	return true;
+}
+
+void CBinLog::close(Segment* seg)
+{
+	if (seg->fd < 0)
+		return;
+
+	// 截掉未用的尾部
+	size_t used = std::min(seg->pos.load(), seg->size);
+	::munmap(seg->base, seg->size);
+	if (::ftruncate(seg->fd, used) != 0)
+		LOG(WARNING) << "binary log truncate to " << used << "B error: " << strerror(errno);
+	::close(seg->fd);
+	seg->fd = -1;
+	seg->name.clear();
+}
+
+namespace {
+
+struct BlogFile
+{
+	time_t mtime;
+	std::string path;
+	uint64_t size;
+
+	bool operator<(const BlogFile& f) const {
+		return mtime != f.mtime ? mtime < f.mtime : path < f.path;
+	}
+};
+
+}
+
+void CBinLog::retain()
+{
+	DIR* dir = ::opendir(_dir.c_str());
+	if (!dir) {
+		LOG(WARNING) << "binary log open dir [" << _dir << "] error: " << strerror(errno);
+		return;
+	}
+
+	// 本进程名各个 pid 的 .blog 都算, 重启前留下的也要清理
+	std::vector<BlogFile> files;
+	uint64_t total = 0;
+	const std::string ext = ".blog";
+	for (struct dirent* ent = ::readdir(dir); ent; ent = ::readdir(dir)) {
+		std::string name(ent->d_name);
+		if (name.size() <= _prefix.size() + ext.size()
+				|| name.compare(0, _prefix.size(), _prefix) != 0
+				|| !isdigit(static_cast<unsigned char>(name[_prefix.size()]))
+				|| name.compare(name.size() - ext.size(), ext.size(), ext) != 0)
+			continue;
+
+		BlogFile f;
+		f.path = _dir + "/" + name;
+		struct stat st;
+		if (::stat(f.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+			continue;
+
+		f.mtime = st.st_mtime;
+		f.size = st.st_size;
+		total += f.size;
+		if (f.path != _slots[0].name && f.path != _slots[1].name)
+			files.push_back(f);
+	}
+	::closedir(dir);
+
+	std::sort(files.begin(), files.end());
+	for (size_t i = 0; i < files.size() && total + _file_size > _max_size; i++) {
+		if (::unlink(files[i].path.c_str()) != 0) {
+			LOG(WARNING) << "binary log remove [" << files[i].path << "] error: " << strerror(errno);
+			continue;
+		}
+		total -= files[i].size;
+		LOG(INFO) << "binary log removed [" << files[i].path << "], total " << util::formatBytes(total);
+	}
+}
+
+void CBinLog::drain(Segment* seg)
+{
+	// 已从 _seg 摘下, 新来的写者复查后会退出, 只等已在写的
+	while (seg->writers.load() != 0)
+		::sched_yield();
+}
+
+void CBinLog::rotate(Segment* full)
+{
+	boost::mutex::scoped_lock lk(_mutex);
+	if (!_enabled || _seg.load() != full)
+		return;
+
+	Segment* next = (full == &_slots[0]) ? &_slots[1] : &_slots[0];
+	if (!open(next)) {
+		LOG(ERR) << "binary log disabled, channel logs fall back to text.";
+		_enabled = false;
+		_seg.store(NULL);
+		drain(full);
+		close(full);
+		return;
+	}
+
+	_seg.store(next);
+	drain(full);
+	close(full);
+}
+
+void CBinLog::append(const char* rec, size_t len)
+{
+	// 原子占位后直接拷贝, 只有写满滚动时加锁.
+	// 先登记写者再复查当前槽位 (均为顺序一致), 与滚动方的 "先摘下再等写者清零" 配对
+	while (_enabled.load(boost::memory_order_relaxed)) {
+		Segment* seg = _seg.load();
+		if (!seg)
+			return;
+
+		seg->writers.fetch_add(1);
+		if (_seg.load() != seg) {
+			seg->writers.fetch_sub(1, boost::memory_order_release);
+			continue;
+		}
+
+		size_t off = seg->pos.fetch_add(len, boost::memory_order_relaxed);
+		if (off + len <= seg->size) {
+			memcpy(seg->base + off, rec, len);
+			seg->writers.fetch_sub(1, boost::memory_order_release);
+			return;
+		}
+		seg->writers.fetch_sub(1, boost::memory_order_release);
+		rotate(seg);
+	}
+}
+
+CBinLog::Record::Record(LogLevel level, binlog::FormatId fmt)
+: _len(sizeof(binlog::RecordHeader))
+{
+	static __thread uint32_t tid = 0;
+	if (tid == 0)
+		tid = gettid();
+
+	binlog::RecordHeader hdr;
+	hdr.len = 0;
+	hdr.fmt = static_cast<uint8_t>(fmt);
+	hdr.level = static_cast<uint8_t>(level);
+	memcpy(_buf, &hdr, sizeof(hdr));
+
+	// 时间记相对文件头的差值, 通常 5~6 字节; 墙上时间可能回拨, 按有符号编码
+	_len += binlog::putVarint(_buf + _len, tid);
+	_len += binlog::putVarint(_buf + _len, binlog::zigzag(static_cast<int64_t>(nowUs() - _epoch_us)));
+}
+
+CBinLog::Record::~Record()
+{
+	uint16_t len = static_cast<uint16_t>(_len);
+	memcpy(_buf, &len, sizeof(len));
+	append(_buf, _len);
+}
+
+CBinLog::Record& CBinLog::Record::putU64(binlog::ArgType type, uint64_t v)
+{
+	if (_len + 1 + binlog::MAX_VARINT > sizeof(_buf))
+		return *this;
+
+	_buf[_len++] = static_cast<char>(type);
+	_len += binlog::putVarint(_buf + _len, v);
+	return *this;
+}
+
+CBinLog::Record& CBinLog::Record::putRaw(binlog::ArgType type, const char* data, size_t len)
+{
+	if (_len + 1 + binlog::MAX_VARINT > sizeof(_buf))
+		return *this;
+
+	// 超长参数截断
+	size_t n = std::min(len, sizeof(_buf) - _len - 1 - binlog::MAX_VARINT);
+	_buf[_len++] = static_cast<char>(type);
+	_len += binlog::putVarint(_buf + _len, n);
+	memcpy(_buf + _len, data, n);
+	_len += n;
+	return *this;
+}
+
+CBinLog::Record& CBinLog::Record::operator<<(const char* v)
+{
+	return putRaw(binlog::ARG_STR, v, strlen(v));
+}
+
+CBinLog::Record& CBinLog::Record::operator<<(const boost::asio::ip::udp::endpoint& ep)
+{
+	if (_len + 1 + 6 > sizeof(_buf))
+		return *this;
+
+	uint32_t addr = ep.address().is_v4() ? htonl(ep.address().to_v4().to_ulong()) : 0;
+	uint16_t port = ep.port();
+	_buf[_len++] = static_cast<char>(binlog::ARG_EP);
+	memcpy(_buf + _len, &addr, sizeof(addr));
+	memcpy(_buf + _len + sizeof(addr), &port, sizeof(port));
+	_len += sizeof(addr) + sizeof(port);
+	return *this;
+}
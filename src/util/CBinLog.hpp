@@ -0,0 +1,111 @@
+/*
+ * CBinLog.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CBINLOG_HPP_
+#define SRC_UTIL_CBINLOG_HPP_
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include "CLogger.hpp"
+#include "CBinLogFormat.hpp"
+
+// 二进制日志: 每条记录为格式 id + 变长编码的参数, 写入 mmap 的滚动文件,
+// 由 tools/binlog_decoder 离线还原为文本. 写入路径无格式化, 无系统调用.
+// 文件打开时预分配, 失败则关闭二进制日志, 调用方随 enabled() 退回文本日志.
+// 本进程名的 .blog 文件总量超过 max_size 时, 开新文件前删掉最旧的.
+class CBinLog
+{
+public:
+	enum { MAX_RECORD = 1024 };
+
+	static bool init(const std::string& proc_name, const std::string& dir, size_t file_size, size_t max_size);
+	static void finit();
+	static bool enabled() { return _enabled.load(boost::memory_order_relaxed); }
+
+	struct Hex
+	{
+		Hex(const char* p, size_t n) : data(p), len(n) {}
+		const char* data;
+		size_t len;
+	};
+
+	struct Bytes
+	{
+		explicit Bytes(uint64_t n) : bytes(n) {}
+		uint64_t bytes;
+	};
+
+	// 在栈上编码一条记录, 析构时提交
+	class Record : private boost::noncopyable
+	{
+	public:
+		Record(LogLevel level, binlog::FormatId fmt);
+		~Record();
+
+		Record& operator<<(uint64_t v) { return putU64(binlog::ARG_U64, v); }
+		Record& operator<<(uint32_t v) { return putU64(binlog::ARG_U64, v); }
+		Record& operator<<(uint16_t v) { return putU64(binlog::ARG_U64, v); }
+		Record& operator<<(int64_t v) { return putU64(binlog::ARG_I64, binlog::zigzag(v)); }
+		Record& operator<<(int v) { return putU64(binlog::ARG_I64, binlog::zigzag(v)); }
+		Record& operator<<(const Bytes& v) { return putU64(binlog::ARG_BYTES, v.bytes); }
+		Record& operator<<(const std::string& v) { return putRaw(binlog::ARG_STR, v.data(), v.size()); }
+		Record& operator<<(const char* v);
+		Record& operator<<(const Hex& v) { return putRaw(binlog::ARG_HEX, v.data, v.len); }
+		Record& operator<<(const boost::asio::ip::udp::endpoint& ep);
+
+	private:
+		Record& putU64(binlog::ArgType type, uint64_t v);
+		Record& putRaw(binlog::ArgType type, const char* data, size_t len);
+
+		char _buf[MAX_RECORD];
+		size_t _len;
+	};
+
+private:
+	// 两个槽位轮流映射文件, 槽位本身不释放, 写者持有计数期间不会被解除映射
+	struct Segment
+	{
+		int fd;
+		std::string name;	// 打开的文件, 保留清理时跳过
+		char* base;
+		size_t size;
+		boost::atomic<size_t> pos;
+		boost::atomic<uint32_t> writers;	// 正在写入的线程数
+	};
+
+	static void append(const char* rec, size_t len);
+	static bool open(Segment* seg);
+	static void close(Segment* seg);
+	static void drain(Segment* seg);
+	static void rotate(Segment* full);
+	static void retain();
+
+	static boost::atomic<bool> _enabled;
+	static std::string _dir;
+	static std::string _prefix;		// 本进程名的文件名前缀, 不含 pid
+	static std::string _path;		// 文件名前缀
+	static size_t _file_size;
+	static size_t _max_size;		// 本进程名 .blog 文件的总量上限
+	static uint64_t _epoch_us;		// 记录时间的基准, 写进每个文件头
+	static uint32_t _seq;
+	static Segment _slots[2];
+	static boost::atomic<Segment*> _seg;
+	static boost::mutex _mutex;
+};
+
+#define BLOG_ENABLED(level) (LOG_ENABLED(level) && CBinLog::enabled())
+
+#define BLOG(level, fmt) \
+	for (bool blog_on_ = BLOG_ENABLED(level); blog_on_; blog_on_ = false) \
+		CBinLog::Record(level, fmt)
+
+#endif /* SRC_UTIL_CBINLOG_HPP_ */
@@ -0,0 +1,109 @@
+/*
+ * CBinLogFormat.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CBINLOGFORMAT_HPP_
+#define SRC_UTIL_CBINLOGFORMAT_HPP_
+
+// 二进制日志文件格式, 写端 CBinLog 与 tools/binlog_decoder 共用, 只追加不修改.
+//
+// 文件: FileHeader, 之后是连续的记录, len 为 0 处即文件结尾.
+// 记录: RecordHeader, varint 线程号, zigzag varint 时间 (相对 start_us 的微秒数),
+// 之后是参数直到记录结尾, 每个参数 1 字节类型 + 数据:
+//   ARG_U64/ARG_BYTES: varint
+//   ARG_I64:           zigzag varint
+//   ARG_STR/ARG_HEX:   varint 长度 + 内容
+//   ARG_EP:            4 字节 IPv4 (网络序) + 2 字节端口
+
+extern "C"
+{
+#include <stddef.h>
+#include <stdint.h>
+}
+
+namespace binlog {
+	const char MAGIC[8] = { 'N', 'A', 'T', 'B', 'L', 'O', 'G', '\0' };
+	enum { VERSION = 1 };
+
+	struct FileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t pid;
+		uint64_t start_us;	// 进程打开二进制日志的时间, 各文件相同
+	};
+
+	struct RecordHeader
+	{
+		uint16_t len;		// 整条记录长度
+		uint8_t fmt;		// FormatId
+		uint8_t level;		// LogLevel
+	};
+
+	enum { MAX_VARINT = 10 };
+
+	// 每字节 7 位, 低位在前, 返回写入的字节数
+	inline size_t putVarint(char* p, uint64_t v)
+	{
+		size_t n = 0;
+		while (v >= 0x80) {
+			p[n++] = static_cast<char>(v | 0x80);
+			v >>= 7;
+		}
+		p[n++] = static_cast<char>(v);
+		return n;
+	}
+
+	// 越界或超长返回 NULL
+	inline const char* getVarint(const char* p, const char* end, uint64_t& v)
+	{
+		v = 0;
+		for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+			uint8_t b = static_cast<uint8_t>(*p++);
+			v |= static_cast<uint64_t>(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				return p;
+		}
+		return NULL;
+	}
+
+	inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+	inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+	enum ArgType {
+		ARG_U64 = 1,
+		ARG_I64,
+		ARG_STR,
+		ARG_HEX,	// 按 util::to_hex 输出
+		ARG_BYTES,	// 按 util::formatBytes 输出
+		ARG_EP
+	};
+
+	enum FormatId {
+		FMT_CHANNEL_OPENED = 1,
+		FMT_CHANNEL_CLOSED,
+		FMT_CHANNEL_DISPLAY,
+		FMT_CHANNEL_AUTH_READ,
+		FMT_CHANNEL_AUTH_ECHO,
+		FMT_MAX
+	};
+
+	// {} 依次替换为参数, 输出与文本日志一致
+	inline const char* format(uint16_t id)
+	{
+		static const char* const formats[FMT_MAX] = {
+			NULL,
+			"channel[{}] ({})[{} --> {} --> {} --> {}]({}) opened.",
+			"channel[{}] closed. takes time: {{}h:{}m:{}s} | TX packets({}): {} | RX packets({}): {} | batch avg({}/{})",
+			"channel[{}] ({})[{} <--> {}]({}) Tx({}ps/{} pps) {{}, {} p} | Rx({}ps/{} pps) {{}, {} p} batch avg({}/{})",
+			"channel[{}] ({})[{} --> {}]({}) {} read auth[{}B]: {}",
+			"channel[{}] ({})[{} <-- {}]({}) {} echo auth[{}B]: {}"
+		};
+		return id < FMT_MAX ? formats[id] : NULL;
+	}
+}
+
+#endif /* SRC_UTIL_CBINLOGFORMAT_HPP_ */
@@ -0,0 +1,30 @@
+/*
+ * CCoarseClock.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#include "CCoarseClock.hpp"
+
+extern "C"
+{
+#include <time.h>
+}
+
+boost::atomic<uint64_t> CCoarseClock::_now_ms(0);
+
+uint64_t CCoarseClock::update()
+{
+	struct timespec ts;
+	if (::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) != 0)
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	uint64_t ms = static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+
+	// 多个线程刷新, 只前进不后退
+	uint64_t cur = _now_ms.load(boost::memory_order_relaxed);
+	while (cur < ms && !_now_ms.compare_exchange_weak(cur, ms, boost::memory_order_relaxed))
+		;
+	return ms;
+}
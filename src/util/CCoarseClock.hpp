@@ -0,0 +1,31 @@
+/*
+ * CCoarseClock.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CCOARSECLOCK_HPP_
+#define SRC_UTIL_CCOARSECLOCK_HPP_
+
+#include <boost/atomic.hpp>
+
+extern "C"
+{
+#include <stdint.h>
+}
+
+// 进程级粗粒度单调时钟 (毫秒).
+// 由各工作线程的时间轮每格调用 update() 刷新, 热路径只做一次 relaxed 读.
+class CCoarseClock
+{
+public:
+	static uint64_t nowMs() { return _now_ms.load(boost::memory_order_relaxed); }
+	static uint32_t nowSecs() { return static_cast<uint32_t>(nowMs() / 1000); }
+	static uint64_t update();
+
+private:
+	static boost::atomic<uint64_t> _now_ms;
+};
+
+#endif /* SRC_UTIL_CCOARSECLOCK_HPP_ */
@@ -24,6 +24,13 @@ extern "C" {
 class CConfig
 {
 public:
+	// 通道 io_context 选择策略
+	enum Placement {
+		PLACE_ROUND_ROBIN = 0,	// 轮询
+		PLACE_SESSION,			// 源会话所在线程
+		PLACE_LEAST_LOADED		// 活动通道最少的线程
+	};
+
 	static CConfig* getInstance()
 	{
 		static CConfig _this;
@@ -42,6 +49,12 @@ public:
 			_log_rotation_size = _cfg.get<size_t>("log.RotationSize", 100);
 			_log_rotation_size = std::min<size_t>(_log_rotation_size, 100);
 			_log_print_level = _cfg.get<uint8_t>("log.PrintLevel", 0);
+			_log_async_queue = _cfg.get<uint32_t>("log.AsyncQueue", 8192);
+			_log_overflow_block = "block" == _cfg.get<std::string>("log.Overflow", "drop");
+			_log_cpu = _cfg.get<int>("log.Cpu", -1);
+			_log_binary = 1 == _cfg.get<uint32_t>("log.Binary", 0);
+			_log_binary_file_size = _cfg.get<size_t>("log.BinaryFileSize", 64);
+			_log_binary_max_size = _cfg.get<size_t>("log.BinaryMaxSize", 1024);
 
 			_srv_ip = _cfg.get<std::string>("srv.IP", "0.0.0.0");
 			_srv_port = _cfg.get<uint16_t>("srv.ListenPort", 10001);
@@ -50,6 +63,10 @@ public:
 			_srv_max_channels = _cfg.get<uint32_t>("srv.MaxChannels", 0);
 			_srv_per_session_max_channels = _cfg.get<uint32_t>("srv.PerSessionMaxChannels", 0);
 			_srv_free_session_expired = _cfg.get<uint32_t>("srv.FreeSessionExpired", 10);
+			_srv_reuse_port = 1 == _cfg.get<uint32_t>("srv.ReusePort", 0);
+			_srv_load_report_interval = _cfg.get<uint32_t>("srv.LoadReportInterval", 0);
+			_srv_worker_cpus = _cfg.get<std::string>("srv.WorkerCpus", "");
+			_srv_session_db_cpu = _cfg.get<int>("srv.SessionDbCpu", -1);
 			if (!_daemon)
 				_daemon = 1 == _cfg.get<uint32_t>("srv.Daemon", 0);
 
@@ -60,6 +77,15 @@ public:
 			_chann_mtu = _cfg.get<uint32_t>("channel.MTU", 1500);
 			_chann_port_expired = _cfg.get<uint32_t>("channel.PortExpired", 30);
 			_chann_display_interval = _cfg.get<uint32_t>("channel.DisplayInterval", 0);
+			_chann_batch_size = _cfg.get<uint32_t>("channel.BatchSize", 1);
+			_chann_batch_size = std::max<uint32_t>(_chann_batch_size, 1);
+			_chann_io_uring = 1 == _cfg.get<uint32_t>("channel.IoUring", 0);
+			_chann_io_uring_buffers = _cfg.get<uint32_t>("channel.IoUringBuffers", 4096);
+			_chann_shared_ports = _cfg.get<uint32_t>("channel.SharedPorts", 0);
+			_chann_placement = parsePlacement(_cfg.get<std::string>("channel.Placement", "roundrobin"));
+			_chann_pool_slab = _cfg.get<uint32_t>("channel.PoolSlab", 256);
+			_chann_huge_pages = 1 == _cfg.get<uint32_t>("channel.HugePages", 0);
+			_chann_counters = 1 == _cfg.get<uint32_t>("channel.Counters", 1);
 
 			loadLocalIp(_srv_ips);
 			//print();
@@ -77,6 +103,12 @@ public:
 	std::string logPath() const { return _log_path; }
 	size_t logRotationSize() const { return _log_rotation_size; }
 	uint8_t logPrintLevel() const { return _log_print_level; }
+	uint32_t logAsyncQueue() const { return _log_async_queue; }
+	bool logOverflowBlock() const { return _log_overflow_block; }
+	int logCpu() const { return _log_cpu; }
+	bool logBinary() const { return _log_binary; }
+	size_t logBinaryFileSize() const { return _log_binary_file_size; }
+	size_t logBinaryMaxSize() const { return _log_binary_max_size; }
 
 	bool daemon() const { return _daemon; }
 	std::string srvIP() const { return _srv_ip; }
@@ -87,6 +119,10 @@ public:
 	uint32_t maxChannels() const { return _srv_max_channels; }
 	uint32_t perSessionMaxChannels() const { return _srv_per_session_max_channels; }
 	uint32_t freeSessionExpired() const { return _srv_free_session_expired; }
+	bool reusePort() const { return _srv_reuse_port; }
+	uint32_t loadReportInterval() const { return _srv_load_report_interval; }
+	std::string workerCpus() const { return _srv_worker_cpus; }
+	int sessionDbCpu() const { return _srv_session_db_cpu; }
 
 	std::string redisIP() const { return _rds_ip; }
 	uint16_t redisPort() const { return _rds_port; }
@@ -95,6 +131,14 @@ public:
 	uint32_t channMTU() const { return _chann_mtu; }
 	uint32_t channPortExpired() const { return _chann_port_expired; }
 	uint32_t channDisplayInterval() const { return _chann_display_interval; }
+	uint32_t channBatchSize() const { return _chann_batch_size; }
+	bool channIoUring() const { return _chann_io_uring; }
+	uint32_t channIoUringBuffers() const { return _chann_io_uring_buffers; }
+	uint32_t channSharedPorts() const { return _chann_shared_ports; }
+	Placement channPlacement() const { return _chann_placement; }
+	uint32_t channPoolSlab() const { return _chann_pool_slab; }
+	bool channHugePages() const { return _chann_huge_pages; }
+	bool channCounters() const { return _chann_counters; }
 
 	/////////////////////////////////////////////////////////////////////
 	std::string print()
@@ -104,6 +148,12 @@ public:
 			<< "][log path: " << logPath()
 			<< "][log rotation size: " << logRotationSize()
 			<< "][log level: " << (int)logPrintLevel()
+			<< "][log async queue: " << logAsyncQueue()
+			<< "][log overflow: " << (logOverflowBlock() ? "block" : "drop")
+			<< "][log cpu: " << logCpu()
+			<< "][log binary: " << std::boolalpha << logBinary()
+			<< "][log binary file size: " << logBinaryFileSize()
+			<< "][log binary max size: " << logBinaryMaxSize()
 			<< "][server ip: " << srvIP()
 			<< "][listen port: " << listenPort()
 			<< "][workers: " << (int)IOWorkers()
@@ -111,17 +161,38 @@ public:
 			<< "][max channels: " << maxChannels()
 			<< "][per session max channels: " << perSessionMaxChannels()
 			<< "][free session expired: " << freeSessionExpired()
+			<< "][reuse port: " << std::boolalpha << reusePort()
+			<< "][load report interval: " << loadReportInterval()
+			<< "][worker cpus: " << workerCpus()
+			<< "][session db cpu: " << sessionDbCpu()
 			<< "][redis addr: " << redisIP()
 			<< "][redis port: " << redisPort()
 			<< "][channel mtu: " << channMTU()
 			<< "][channel port expired: " << channPortExpired()
 			<< "][channel display interval: " << channDisplayInterval()
+			<< "][channel batch size: " << channBatchSize()
+			<< "][channel io_uring: " << std::boolalpha << channIoUring()
+			<< "][channel io_uring buffers: " << channIoUringBuffers()
+			<< "][channel shared ports: " << channSharedPorts()
+			<< "][channel placement: " << (int)channPlacement()
+			<< "][channel pool slab: " << channPoolSlab()
+			<< "][channel huge pages: " << std::boolalpha << channHugePages()
+			<< "][channel counters: " << std::boolalpha << channCounters()
 			<< "][is daemon: " << std::boolalpha << daemon()
 			<< "]";
 		return ss.str();
 	}
 
 protected:
+	Placement parsePlacement(const std::string& name)
+	{
+		if (name == "session")
+			return PLACE_SESSION;
+		if (name == "leastloaded")
+			return PLACE_LEAST_LOADED;
+		return PLACE_ROUND_ROBIN;
+	}
+
 	bool loadLocalIp(std::vector<std::string>&iplist)
 	{
 		iplist.clear();
@@ -196,6 +267,12 @@ protected:
 	, _log_path("/usr/local/log/")
 	, _log_rotation_size(0)
 	, _log_print_level(0)
+	, _log_async_queue(8192)
+	, _log_overflow_block(false)
+	, _log_cpu(-1)
+	, _log_binary(false)
+	, _log_binary_file_size(64)
+	, _log_binary_max_size(1024)
 	, _daemon(false)
 	, _srv_ips()
 	, _srv_ip("")
@@ -205,11 +282,23 @@ protected:
 	, _srv_max_channels(0)
 	, _srv_per_session_max_channels(0)
 	, _srv_free_session_expired(0)
+	, _srv_reuse_port(false)
+	, _srv_load_report_interval(0)
+	, _srv_worker_cpus("")
+	, _srv_session_db_cpu(-1)
 	, _rds_ip("")
 	, _rds_port(0)
 	, _chann_mtu(1500)
 	, _chann_port_expired(0)
 	, _chann_display_interval(0)
+	, _chann_batch_size(1)
+	, _chann_io_uring(false)
+	, _chann_io_uring_buffers(4096)
+	, _chann_shared_ports(0)
+	, _chann_placement(PLACE_ROUND_ROBIN)
+	, _chann_pool_slab(256)
+	, _chann_huge_pages(false)
+	, _chann_counters(true)
 	{}
 
 private:
@@ -221,6 +310,12 @@ private:
 	std::string _log_path; // 日志路径
 	size_t  	_log_rotation_size;// 日志旋转大小(MB)
 	uint8_t 	_log_print_level; // 日志输出等级
+	uint32_t	_log_async_queue; // 每线程异步日志队列大小, 0 为同步写
+	bool		_log_overflow_block; // 队列满时阻塞(block), 默认丢弃(drop)
+	int			_log_cpu; // 日志写线程绑定的 CPU, -1 不绑定
+	bool		_log_binary; // 通道热点日志写二进制格式 (tools/binlog_decoder 还原)
+	size_t		_log_binary_file_size; // 二进制日志单个文件大小(MB)
+	size_t		_log_binary_max_size; // 二进制日志文件总量上限(MB), 超出删最旧的
 
 	bool		_daemon;
 	std::vector<std::string> _srv_ips; // 所有网卡IP
@@ -231,6 +326,10 @@ private:
 	uint32_t 	_srv_max_channels; // 最大通道数 (0 未限制)
 	uint32_t	_srv_per_session_max_channels; // 每用户最大通道数 (0 未限制)
 	uint32_t 	_srv_free_session_expired; // 未登陆用户过期时间(秒)
+	bool		_srv_reuse_port; // 每个IO线程一个 SO_REUSEPORT 监听
+	uint32_t	_srv_load_report_interval; // IO线程负载输出间隔(秒), 0 不输出
+	std::string _srv_worker_cpus; // IO线程绑定的CPU列表, 如 "2-5,8", 空为不绑定
+	int			_srv_session_db_cpu; // 会话库线程绑定的CPU, -1 不绑定
 
 	std::string _rds_ip; // redis ip
 	uint16_t 	_rds_port; // redis port
@@ -239,6 +338,14 @@ private:
 	uint32_t	_chann_mtu; // 通道MTU
 	uint32_t	_chann_port_expired; // 通道端口过期时间(秒)
 	uint32_t 	_chann_display_interval; // 通道信息输出间隔(秒)
+	uint32_t	_chann_batch_size; // 通道每次批量收发的包数 (1 不批量)
+	bool		_chann_io_uring; // 通道使用 io_uring 中继
+	uint32_t	_chann_io_uring_buffers; // 每个IO线程 io_uring 缓冲个数
+	uint32_t	_chann_shared_ports; // 每个IO线程每个IP共享UDP端口数, 0 为每通道独占端口
+	Placement	_chann_placement; // 通道线程选择: roundrobin / session / leastloaded
+	uint32_t	_chann_pool_slab; // 缓冲池每次扩容的缓冲个数
+	bool		_chann_huge_pages; // 缓冲池使用大页
+	bool		_chann_counters; // 通道流量计数开关
 };
 
 #define gConfig (CConfig::getInstance())
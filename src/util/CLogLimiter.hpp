@@ -0,0 +1,78 @@
+/*
+ * CLogLimiter.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CLOGLIMITER_HPP_
+#define SRC_UTIL_CLOGLIMITER_HPP_
+
+#include <ostream>
+#include "CLogger.hpp"
+#include "CCoarseClock.hpp"
+
+// 日志限速: 每个时间窗最多放行 burst 条, 其余只计数不格式化,
+// 下一条放行的日志带上被抑制的条数. 单线程使用.
+class CLogLimiter
+{
+public:
+	enum { BURST = 5, WINDOW_MS = 1000 };
+
+	// 放行时输出 "[N similar messages suppressed] "
+	struct Note
+	{
+		explicit Note(uint32_t n) : suppressed(n) {}
+		uint32_t suppressed;
+	};
+
+	explicit CLogLimiter(uint32_t burst = BURST, uint32_t window_ms = WINDOW_MS)
+	: _burst(burst)
+	, _window_ms(window_ms)
+	, _window_start(0)
+	, _count(0)
+	, _suppressed(0)
+	{}
+
+	bool allow() {
+		uint64_t now = CCoarseClock::nowMs();
+		if (now - _window_start >= _window_ms) {
+			_window_start = now;
+			_count = 0;
+		}
+
+		if (_count < _burst) {
+			_count++;
+			return true;
+		}
+		_suppressed++;
+		return false;
+	}
+
+	uint32_t suppressed() const { return _suppressed; }
+	Note note() {
+		Note n(_suppressed);
+		_suppressed = 0;
+		return n;
+	}
+
+private:
+	uint32_t _burst;
+	uint32_t _window_ms;
+	uint64_t _window_start;
+	uint32_t _count;
+	uint32_t _suppressed;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const CLogLimiter::Note& note)
+{
+	if (note.suppressed > 0)
+		os << "[" << note.suppressed << " similar messages suppressed] ";
+	return os;
+}
+
+// 被限速时既不打开日志记录也不格式化参数
+#define LOG_LIMIT(limiter, level) \
+	if (!(limiter).allow()) {} else LOG(level) << (limiter).note()
+
+#endif /* SRC_UTIL_CLOGLIMITER_HPP_ */
@@ -23,6 +23,13 @@
 #include <boost/log/sources/severity_feature.hpp>
 #include <boost/log/expressions/formatters.hpp>
 #include <boost/phoenix.hpp>
+#include <boost/log/sinks/sink.hpp>
+#include <boost/log/core/record_view.hpp>
+#include <boost/log/attributes/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 #include "util.hpp"
 
 namespace logging = boost::log;
@@ -68,13 +75,242 @@ inline std::basic_ostream< CharT, TraitsT >& operator<< (
 			"REPORT"
 	};
 	if (static_cast<std::size_t>(lvl) < (sizeof(levels) / sizeof(*levels)))
-		strm << levels[lvl] << "] [#" << gettid();
+		strm << levels[lvl];
 	else
 		strm << static_cast<int>(lvl);
 	return strm;
 }
 
-void initLog(const std::string& proc_name, const std::string& path, size_t rotation_size, uint8_t level)
+// 线程号在写日志的线程上取, 异步写时也不会变成写线程的
+static long currentTid()
+{
+	return gettid();
+}
+
+// 异步日志前端: 每个写日志的线程一个无锁单生产者环形队列,
+// 独立写线程批量取出, 在写线程上格式化并写文件, 每批 flush 一次.
+class CAsyncLogSink : public sinks::sink
+{
+public:
+	enum { IDLE_WAIT_MS = 10 };
+
+	CAsyncLogSink(const boost::shared_ptr<sinks::text_file_backend>& backend,
+			const logging::filter& filter,
+			const logging::formatter& formatter,
+			uint32_t queue_size, bool block, int cpu)
+	: sinks::sink(true)
+	, _backend(backend)
+	, _filter(filter)
+	, _formatter(formatter)
+	, _queue_size(2)
+	, _block(block)
+	, _cpu(cpu)
+	, _local(&CAsyncLogSink::keepRing)
+	, _running(false)
+	, _producers(0)
+	, _dropped(0)
+	, _dropped_reported(0)
+	{
+		while (_queue_size < queue_size)
+			_queue_size <<= 1;
+	}
+
+	~CAsyncLogSink()
+	{
+		stop();
+		for (size_t i = 0; i < _rings.size(); i++)
+			delete _rings[i];
+	}
+
+	void start()
+	{
+		_running = true;
+		_thread = boost::thread(boost::bind(&CAsyncLogSink::writer, this));
+	}
+
+	// 先摘下 _running, 再等已过检查的生产者入队完, 最后一次 drain 才收得全
+	void stop()
+	{
+		if (!_running.exchange(false))
+			return;
+		_thread.join();
+		while (_producers.load() != 0)
+			boost::this_thread::yield();
+		drain();
+	}
+
+	virtual bool will_consume(logging::attribute_value_set const& attrs)
+	{
+		return _filter(attrs);
+	}
+
+	virtual void consume(logging::record_view const& rec)
+	{
+		// 先登记生产者再查 _running (均为顺序一致), 与 stop() 的 "先摘下再等生产者清零" 配对
+		_producers.fetch_add(1);
+		if (!_running.load()) {
+			_producers.fetch_sub(1, boost::memory_order_release);
+			writeSync(rec);
+			return;
+		}
+
+		Ring* ring = localRing();
+		while (!ring->push(rec)) {
+			if (!_running.load(boost::memory_order_acquire)) {
+				// 停止时队列仍满: 写线程已不再取, 改为同步写
+				_producers.fetch_sub(1, boost::memory_order_release);
+				writeSync(rec);
+				return;
+			}
+			if (!_block) {
+				_dropped.fetch_add(1, boost::memory_order_relaxed);
+				break;
+			}
+			boost::this_thread::sleep_for(boost::chrono::microseconds(100));
+		}
+		_producers.fetch_sub(1, boost::memory_order_release);
+	}
+
+	virtual void flush()
+	{
+		drain();
+	}
+
+private:
+	// 单生产者单消费者环, 消费端由 _write_mutex 串行
+	class Ring
+	{
+	public:
+		explicit Ring(size_t size) : _slots(size), _mask(size - 1), _head(0), _tail(0) {}
+
+		bool push(logging::record_view const& rec)
+		{
+			size_t tail = _tail.load(boost::memory_order_relaxed);
+			if (tail - _head.load(boost::memory_order_acquire) > _mask)
+				return false;
+
+			_slots[tail & _mask] = rec;
+			_tail.store(tail + 1, boost::memory_order_release);
+			return true;
+		}
+
+		bool pop(logging::record_view& rec)
+		{
+			size_t head = _head.load(boost::memory_order_relaxed);
+			if (head == _tail.load(boost::memory_order_acquire))
+				return false;
+
+			rec.swap(_slots[head & _mask]);
+			_head.store(head + 1, boost::memory_order_release);
+			return true;
+		}
+
+	private:
+		std::vector<logging::record_view> _slots;
+		size_t _mask;
+		boost::atomic<size_t> _head;
+		boost::atomic<size_t> _tail;
+	};
+
+	static void keepRing(Ring*) {}
+
+	Ring* localRing()
+	{
+		Ring* ring = _local.get();
+		if (!ring) {
+			ring = new Ring(_queue_size);
+			_local.reset(ring);
+
+			boost::mutex::scoped_lock lk(_rings_mutex);
+			_rings.push_back(ring);
+		}
+		return ring;
+	}
+
+	void write(logging::record_view const& rec)
+	{
+		uint64_t dropped = _dropped.load(boost::memory_order_relaxed);
+		if (dropped != _dropped_reported) {
+			std::stringstream ss;
+			ss << "[" << (dropped - _dropped_reported) << " log records dropped, queue full]";
+			_backend->consume(rec, ss.str());
+			_dropped_reported = dropped;
+		}
+
+		_line.clear();
+		logging::formatting_ostream strm(_line);
+		_formatter(rec, strm);
+		strm.flush();
+		_backend->consume(rec, _line);
+	}
+
+	// 写线程未运行时同步写; 先取完队列里的, 本线程之前入队的记录不会排到后面
+	void writeSync(logging::record_view const& rec)
+	{
+		drain();
+		boost::mutex::scoped_lock lk(_write_mutex);
+		write(rec);
+		_backend->flush();
+	}
+
+	size_t drain()
+	{
+		boost::mutex::scoped_lock lk(_write_mutex);
+		std::vector<Ring*> rings;
+		{
+			boost::mutex::scoped_lock rlk(_rings_mutex);
+			rings = _rings;
+		}
+
+		size_t n = 0;
+		logging::record_view rec;
+		for (size_t i = 0; i < rings.size(); i++) {
+			while (rings[i]->pop(rec)) {
+				write(rec);
+				rec.reset();
+				n++;
+			}
+		}
+
+		if (n > 0)
+			_backend->flush();
+		return n;
+	}
+
+	void writer()
+	{
+		util::setThreadAffinity(_cpu);
+		while (_running.load(boost::memory_order_acquire)) {
+			if (drain() == 0)
+				boost::this_thread::sleep_for(boost::chrono::milliseconds(IDLE_WAIT_MS));
+		}
+	}
+
+	boost::shared_ptr<sinks::text_file_backend> _backend;
+	logging::filter _filter;
+	logging::formatter _formatter;
+	uint32_t _queue_size;	// 每线程环大小, 2 的幂
+	bool _block;			// 队列满时阻塞等待, 否则丢弃计数
+	int _cpu;
+
+	boost::thread_specific_ptr<Ring> _local;
+	boost::mutex _rings_mutex;
+	std::vector<Ring*> _rings;
+
+	boost::mutex _write_mutex;
+	std::string _line;
+	boost::thread _thread;
+	boost::atomic<bool> _running;
+	boost::atomic<uint32_t> _producers;	// 已过 _running 检查, 正在入队的线程数
+	boost::atomic<uint64_t> _dropped;
+	uint64_t _dropped_reported;
+};
+
+static boost::shared_ptr<CAsyncLogSink> gAsyncSink;
+LogLevel gLogLevel = TRACE;
+
+void initLog(const std::string& proc_name, const std::string& path, size_t rotation_size, uint8_t level,
+		uint32_t async_queue, bool block, int cpu)
 {
 	boost::filesystem::path log_path(path);
 
@@ -96,27 +332,41 @@ void initLog(const std::string& proc_name, const std::string& path, size_t rotat
 				keywords::time_based_rotation = sinks::file::rotation_at_time_point(7, 0, 0),
 				keywords::min_free_space = 30 * 1024 * 1024,
 				keywords::enable_final_rotation = false,
-				keywords::auto_flush = true
+				keywords::auto_flush = (async_queue == 0)
 			);
 
-
-	typedef sinks::synchronous_sink<sinks::text_file_backend> FileSink;
-	boost::shared_ptr<FileSink> file_sink = boost::make_shared<FileSink>(file_backend);
-	file_sink->set_formatter (
-		expr::format("[P:%1%] [%2%] [%3%]> %4%")
+	logging::formatter formatter =
+		expr::format("[P:%1%] [%2%] [%3%] [#%4%]> %5%")
 		% boost::phoenix::bind(&get_native_process_id, process_id.or_none())
 		% expr::format_date_time<boost::posix_time::ptime>("TimeStamp", "%Y%m%d %H:%M:%S.%f")
 		% expr::attr<LogLevel>("Severity")
-		% expr::smessage
-	);
-	file_sink->set_filter(expr::attr<LogLevel>("Severity") >= level);
+		% expr::attr<long>("TID")
+		% expr::smessage;
+	logging::filter filter = expr::attr<LogLevel>("Severity") >= level;
+	gLogLevel = static_cast<LogLevel>(level);
+
+	if (async_queue > 0) {
+		gAsyncSink = boost::make_shared<CAsyncLogSink>(file_backend, filter, formatter, async_queue, block, cpu);
+		core->add_sink(gAsyncSink);
+		gAsyncSink->start();
+	}
+	else {
+		typedef sinks::synchronous_sink<sinks::text_file_backend> FileSink;
+		boost::shared_ptr<FileSink> file_sink = boost::make_shared<FileSink>(file_backend);
+		file_sink->set_formatter(formatter);
+		file_sink->set_filter(filter);
+		core->add_sink(file_sink);
+	}
 
-	core->add_sink(file_sink);
 	core->add_global_attribute("Scopes", attrs::named_scope());
+	core->add_global_attribute("TID", attrs::make_function(&currentTid));
 	logging::add_common_attributes();
 }
 
 void finitLog()
 {
+	if (gAsyncSink)
+		gAsyncSink->stop();
 	boost::log::core::get()->remove_all_sinks();
+	gAsyncSink.reset();
 }
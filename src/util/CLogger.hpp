@@ -23,15 +23,32 @@ enum LogLevel {
 	REPORT
 };
 
+// async_queue: 每个线程的异步日志环大小, 0 为同步写;
+// block: 环满时阻塞, 否则丢弃并计数; cpu: 写线程绑定的 CPU, < 0 不绑定
 void initLog(const std::string& proc_name,
 		const std::string& log_dir,
 		size_t rotation_size,
-		uint8_t level);
+		uint8_t level,
+		uint32_t async_queue = 0,
+		bool block = false,
+		int cpu = -1);
 void finitLog();
 
 BOOST_LOG_INLINE_GLOBAL_LOGGER_DEFAULT(logger, boost::log::sources::severity_logger_mt<LogLevel>)
 
-#define LOG(level)  BOOST_LOG_STREAM_SEV(logger::get(), level)
+// 编译期最低等级, 低于它的 LOG 语句连同参数一起被编译掉, 如 -DLOG_MIN_LEVEL=INFO
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL TRACE
+#endif
+
+// 运行期等级, 由 initLog 设置; 低于它时不打开日志记录, 也不求值流参数
+extern LogLevel gLogLevel;
+
+#define LOG_ENABLED(level) ((level) >= LOG_MIN_LEVEL && (level) >= gLogLevel)
+
+#define LOG(level) \
+	for (bool log_on_ = LOG_ENABLED(level); log_on_; log_on_ = false) \
+		BOOST_LOG_STREAM_SEV(logger::get(), level)
 #define LOGF(level) LOG(level) << "[" << __FILE__ << ":" << __FUNCTION__ << "():" << __LINE__ << "] >> "
 
 #endif
@@ -0,0 +1,102 @@
+/*
+ * CShardedMap.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CSHARDEDMAP_HPP_
+#define SRC_UTIL_CSHARDEDMAP_HPP_
+
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+
+extern "C"
+{
+#include <stddef.h>
+}
+
+// 分段加锁的线程安全 map: 按 key 的哈希分到 SHARDS 个段, 每段一把锁,
+// 不同段的读写互不阻塞. 段间留一个缓存行, 避免相邻段的锁伪共享.
+// 选段和段内查找共用同一个哈希函数 H, 预先算好哈希的 key 只算一次.
+template<typename K, typename V, typename H = boost::hash<K>, size_t SHARDS = 64>
+class CShardedMap : private boost::noncopyable
+{
+public:
+	typedef boost::unordered_map<K, V, H> Container;
+	typedef typename Container::value_type value_type;
+	typedef typename Container::iterator iterator;
+
+	bool insert(const K& key, const V& value) {
+		Shard& s = shard(key);
+		boost::mutex::scoped_lock lk(s.mutex);
+		return s.container.insert(value_type(key, value)).second;
+	}
+
+	bool remove(const K& key) {
+		Shard& s = shard(key);
+		boost::mutex::scoped_lock lk(s.mutex);
+		return s.container.erase(key) > 0;
+	}
+
+	bool get(const K& key, V& value) {
+		Shard& s = shard(key);
+		boost::mutex::scoped_lock lk(s.mutex);
+		iterator it = s.container.find(key);
+		if (s.container.end() == it)
+			return false;
+
+		value = it->second;
+		return true;
+	}
+
+	// 各段依次加锁累加, 只是近似值
+	size_t size() {
+		size_t n = 0;
+		for (size_t i = 0; i < SHARDS; i++) {
+			boost::mutex::scoped_lock lk(_shards[i].mutex);
+			n += _shards[i].container.size();
+		}
+		return n;
+	}
+
+private:
+	struct Shard
+	{
+		boost::mutex mutex;
+		Container container;
+		char pad[64];
+	};
+
+	Shard& shard(const K& key) {
+		return _shards[H()(key) % SHARDS];
+	}
+
+	Shard _shards[SHARDS];
+};
+
+// 带预算哈希的字符串 key, 构造时算一次, 之后选段/查找/比较都复用
+struct CHashedString
+{
+	explicit CHashedString(const std::string& s)
+	: str(s)
+	, hash(boost::hash<std::string>()(s))
+	{}
+
+	bool operator==(const CHashedString& other) const {
+		return hash == other.hash && str == other.str;
+	}
+
+	struct Hash
+	{
+		size_t operator()(const CHashedString& key) const { return key.hash; }
+	};
+
+	std::string str;
+	size_t hash;
+};
+
+#endif /* SRC_UTIL_CSHARDEDMAP_HPP_ */
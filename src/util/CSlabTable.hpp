@@ -0,0 +1,203 @@
+/*
+ * CSlabTable.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ */
+
+#ifndef SRC_UTIL_CSLABTABLE_HPP_
+#define SRC_UTIL_CSLABTABLE_HPP_
+
+#include <deque>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/smart_ptr/weak_ptr.hpp>
+
+extern "C"
+{
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+}
+
+// 按槽位索引的对象表: id = 代数(高 12 位) | 槽位(低 20 位).
+// 查找是分片数组下标 + 代数比较, 不做哈希; 槽位释放时代数加一, 旧 id 自然失效.
+// 槽位按 1024 个一片按需申请, 片地址只增不删, 读时不用锁片表.
+// 空闲槽位先进先出复用, 尽量推迟同一槽位的代数回绕.
+// 读不加锁: 槽位标签 (代数 | 状态) 原子读取比对; 读弱指针期间登记读者,
+// 写者 (按分片加锁互斥) 先改标签摘下, 等读者清零后再动弱指针.
+template <typename T>
+class CSlabTable : private boost::noncopyable
+{
+public:
+	typedef boost::shared_ptr<T> Ptr;
+	typedef boost::weak_ptr<T> Wptr;
+
+	enum { INDEX_BITS = 20 };
+	enum { INDEX_MASK = (1u << INDEX_BITS) - 1 };
+	enum { GEN_MASK = (1u << (32 - INDEX_BITS)) - 1 };
+	enum { SLAB_BITS = 10 };
+	enum { SLAB_SIZE = 1u << SLAB_BITS };
+	enum { MAX_SLABS = (INDEX_MASK + 1) / SLAB_SIZE };
+	enum { STRIPES = 64 };
+
+	CSlabTable() : _slab_num(0), _next(0), _size(0) {
+		for (size_t i = 0; i < MAX_SLABS; i++)
+			_slabs[i] = NULL;
+	}
+
+	~CSlabTable() {
+		for (size_t i = 0; i < MAX_SLABS; i++)
+			delete[] _slabs[i];
+	}
+
+	static uint32_t index(uint32_t id) { return id & INDEX_MASK; }
+	static uint32_t generation(uint32_t id) { return id >> INDEX_BITS; }
+
+	// 占一个空槽位, 返回 id; 表满返回 0
+	uint32_t reserve() {
+		uint32_t idx = 0;
+		{
+			boost::mutex::scoped_lock lk(_free_mutex);
+			if (!_free.empty()) {
+				idx = _free.front();
+				_free.pop_front();
+			}
+			else {
+				if (_next > INDEX_MASK)
+					return 0;
+
+				idx = _next++;
+				uint32_t n = idx >> SLAB_BITS;
+				if (n == _slab_num.load(boost::memory_order_relaxed)) {
+					_slabs[n] = new Slot[SLAB_SIZE];
+					_slab_num.store(n + 1, boost::memory_order_release);
+				}
+			}
+		}
+
+		Slot& s = _slabs[idx >> SLAB_BITS][idx & (SLAB_SIZE - 1)];
+		boost::mutex::scoped_lock lk(stripe(idx));
+		uint32_t gen = s.tag.load(boost::memory_order_relaxed) >> INDEX_BITS;
+		s.tag.store((gen << INDEX_BITS) | USED);
+		_size.fetch_add(1, boost::memory_order_relaxed);
+		return (gen << INDEX_BITS) | idx;
+	}
+
+	bool set(uint32_t id, const Ptr& p) {
+		Slot* s = slot(id);
+		if (!s)
+			return false;
+
+		boost::mutex::scoped_lock lk(stripe(index(id)));
+		uint32_t tag = s->tag.load(boost::memory_order_relaxed);
+		if (!(tag & USED) || (tag >> INDEX_BITS) != generation(id))
+			return false;
+
+		if (tag & LIVE) {
+			s->tag.store(tag & ~LIVE);
+			drain(*s);
+		}
+		s->ptr = p;
+		s->tag.store(tag | LIVE, boost::memory_order_release);
+		return true;
+	}
+
+	uint32_t insert(const Ptr& p) {
+		uint32_t id = reserve();
+		if (id)
+			set(id, p);
+		return id;
+	}
+
+	Ptr get(uint32_t id) {
+		Slot* s = slot(id);
+		if (!s)
+			return Ptr();
+
+		uint32_t want = (generation(id) << INDEX_BITS) | USED | LIVE;
+		if (s->tag.load(boost::memory_order_acquire) != want)
+			return Ptr();
+
+		// 先登记再复查标签 (均为顺序一致), 与写者 "先摘下再等读者清零" 配对
+		Ptr p;
+		s->readers.fetch_add(1);
+		if (s->tag.load() == want)
+			p = s->ptr.lock();
+		s->readers.fetch_sub(1, boost::memory_order_release);
+		return p;
+	}
+
+	// 代数不符 (已释放过) 时什么都不做, 重复释放是安全的
+	bool remove(uint32_t id) {
+		Slot* s = slot(id);
+		if (!s)
+			return false;
+
+		{
+			boost::mutex::scoped_lock lk(stripe(index(id)));
+			uint32_t tag = s->tag.load(boost::memory_order_relaxed);
+			if (!(tag & USED) || (tag >> INDEX_BITS) != generation(id))
+				return false;
+
+			uint32_t gen = ((tag >> INDEX_BITS) + 1) & GEN_MASK;
+			if (gen == 0)
+				gen = 1;
+			s->tag.store(gen << INDEX_BITS);
+			drain(*s);
+			s->ptr.reset();
+		}
+
+		_size.fetch_sub(1, boost::memory_order_relaxed);
+		boost::mutex::scoped_lock lk(_free_mutex);
+		_free.push_back(index(id));
+		return true;
+	}
+
+	size_t size() const { return _size.load(boost::memory_order_relaxed); }
+
+private:
+	enum { USED = 1, LIVE = 2 };	// 标签低位: 已占用, 指针已发布
+
+	struct Slot
+	{
+		Slot() : tag(1u << INDEX_BITS), readers(0) {}
+		boost::atomic<uint32_t> tag;	// 代数(高 12 位, 从 1 开始, id 不会为 0) | 状态位
+		boost::atomic<uint32_t> readers;	// 正在读 ptr 的线程数
+		Wptr ptr;
+	};
+
+	struct Stripe
+	{
+		boost::mutex mutex;
+		char pad[64];
+	};
+
+	Slot* slot(uint32_t id) {
+		uint32_t idx = index(id);
+		if ((idx >> SLAB_BITS) >= _slab_num.load(boost::memory_order_acquire))
+			return NULL;
+		return &_slabs[idx >> SLAB_BITS][idx & (SLAB_SIZE - 1)];
+	}
+
+	boost::mutex& stripe(uint32_t idx) { return _stripes[idx % STRIPES].mutex; }
+
+	// 标签已摘下, 新来的读者复查后不会碰 ptr, 只等已在读的
+	static void drain(Slot& s) {
+		while (s.readers.load() != 0)
+			::sched_yield();
+	}
+
+	Slot* _slabs[MAX_SLABS];
+	boost::atomic<uint32_t> _slab_num;
+	Stripe _stripes[STRIPES];
+
+	boost::mutex _free_mutex;
+	std::deque<uint32_t> _free;
+	uint32_t _next;
+	boost::atomic<size_t> _size;
+};
+
+#endif /* SRC_UTIL_CSLABTABLE_HPP_ */
@@ -16,6 +16,10 @@ extern "C"
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <execinfo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <sys/random.h>
 }
 
 namespace util {
@@ -112,4 +116,52 @@ namespace util {
 	    free(strings);
 	    outfile.close();
 	}
+
+	std::vector<int> parseCpuList(const std::string& list)
+	{
+		std::vector<int> cpus;
+		std::stringstream ss(list);
+		std::string item;
+		while (std::getline(ss, item, ',')) {
+			if (item.empty())
+				continue;
+
+			int first = -1, last = -1;
+			if (sscanf(item.c_str(), "%d-%d", &first, &last) == 2) {
+				for (int cpu = first; cpu <= last; cpu++)
+					cpus.push_back(cpu);
+			}
+			else if (first >= 0) {
+				cpus.push_back(first);
+			}
+		}
+		return cpus;
+	}
+
+	bool setThreadAffinity(int cpu)
+	{
+		if (cpu < 0)
+			return true;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+
+	bool randomBytes(void* buf, size_t len)
+	{
+		char* p = static_cast<char*>(buf);
+		while (len > 0) {
+			ssize_t n = getrandom(p, len, 0);
+			if (n < 0) {
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+			p += n;
+			len -= n;
+		}
+		return true;
+	}
 }
@@ -10,9 +10,11 @@
 
 
 #include <string>
+#include <vector>
 #include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 #include <boost/chrono.hpp>
 
 extern "C"
@@ -37,10 +39,31 @@ namespace util {
 	inline std::string to_hex(const char*pbuf, const size_t len);
 	inline std::string to_hex(std::string const& s);
 
+	// 查表编码, 每字节输出 "xx " 三个字符; out 至少 len * 3 字节, 返回写入长度
+	inline size_t to_hex(const char* pbuf, const size_t len, char* out);
+
+	// 直接写入输出流, 分段经栈上缓冲编码, 不申请堆内存: LOG(...) << util::hex(buf, len)
+	struct Hex
+	{
+		Hex(const char* p, size_t n) : data(p), len(n) {}
+		const char* data;
+		size_t len;
+	};
+	inline Hex hex(const char* pbuf, const size_t len) { return Hex(pbuf, len); }
+	inline Hex hex(std::string const& s) { return Hex(s.data(), s.size()); }
+	inline std::ostream& operator<<(std::ostream& os, const Hex& h);
+
 	bool daemon();
 	std::string formatBytes(const uint64_t& bytes);
 
 	void printBacktrace(int sig);
+
+	// CPU 绑定: "0-3,8" 形式的列表; cpu < 0 不绑定
+	std::vector<int> parseCpuList(const std::string& list);
+	bool setThreadAffinity(int cpu);
+
+	// 从内核随机源取 len 字节, 用于不可猜的令牌
+	bool randomBytes(void* buf, size_t len);
 	inline time_t steady_clock_to_time_t( boost::chrono::steady_clock::time_point t);
 }
 
@@ -53,13 +76,45 @@ std::string util::to_string(const T v)
 	return ss.str();
 }
 
+size_t util::to_hex(const char* pbuf, const size_t len, char* out)
+{
+	static const char digits[] =
+			"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+			"202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+			"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+			"606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+			"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+			"a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+			"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+			"e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+	const unsigned char* in = reinterpret_cast<const unsigned char*>(pbuf);
+	for (size_t i = 0; i < len; i++) {
+		const char* d = &digits[in[i] * 2];
+		out[0] = d[0];
+		out[1] = d[1];
+		out[2] = ' ';
+		out += 3;
+	}
+	return len * 3;
+}
+
 std::string util::to_hex(const char*pbuf, const size_t len)
 {
-	std::ostringstream out;
-	out << std::hex;
-	for (size_t i = 0; i < len; i++)
-		out << std::setfill('0') << std::setw(2) << (static_cast<short>(pbuf[i]) & 0xff) << " ";
-	return out.str();
+	std::string out(len * 3, ' ');
+	if (len > 0)
+		to_hex(pbuf, len, &out[0]);
+	return out;
+}
+
+std::ostream& util::operator<<(std::ostream& os, const Hex& h)
+{
+	char buf[3 * 256];
+	for (size_t off = 0; off < h.len; off += 256) {
+		size_t n = std::min<size_t>(h.len - off, 256);
+		os.write(buf, to_hex(h.data + off, n, buf));
+	}
+	return os;
 }
 
 std::string util::to_hex(std::string const& s)
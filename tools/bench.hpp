@@ -0,0 +1,133 @@
+/*
+ * bench.hpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * tools 下压测和测试程序共用的小工具: 计时, 常驻内存, 驱动 io_context, 回环上的会话.
+ */
+
+#ifndef TOOLS_BENCH_HPP_
+#define TOOLS_BENCH_HPP_
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+
+#include "net/CServer.hpp"
+#include "net/CSession.hpp"
+#include "net/CSessionMgr.hpp"
+
+extern "C"
+{
+#include <unistd.h>
+}
+
+namespace asio {
+	using namespace boost::asio;
+}
+
+namespace bench {
+
+typedef boost::chrono::steady_clock Clock;
+
+// 从 start 到现在平均每次的纳秒数, start 可以是任一 boost::chrono 时钟的时间点
+template <typename TimePoint>
+inline double nsPerOp(TimePoint start, size_t n)
+{
+	typedef typename TimePoint::clock C;
+	return static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(C::now() - start).count()) / n;
+}
+
+// 本进程常驻内存 KB
+inline long rssKb()
+{
+	long pages = 0, rss = 0;
+	FILE* fp = fopen("/proc/self/statm", "r");
+	if (fp) {
+		if (fscanf(fp, "%ld %ld", &pages, &rss) != 2)
+			rss = 0;
+		fclose(fp);
+	}
+	return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 跑完已就绪的回调; rounds > 1 时每轮间隔 sleep_us, 留时间给内核投递数据报
+inline void pump(asio::io_context& io, int rounds = 1, useconds_t sleep_us = 0)
+{
+	for (int i = 0; i < rounds; i++) {
+		io.poll();
+		io.restart();
+		if (sleep_us)
+			usleep(sleep_us);
+	}
+}
+
+// 会话管理器: 挂在不启动的 CServer 上, 会话库也不连 redis.
+// 夹具里的会话不登录, 停止时管理器只通知服务器, 不碰会话表和会话库.
+class Manager
+{
+public:
+	Manager()
+	: _server(boost::make_shared<CServer>(1))
+	, _mgr(boost::make_shared<CSessionMgr>(_server, "127.0.0.1", 6379, ""))
+	{}
+
+	const SessionMgrPtr& get() const { return _mgr; }
+
+private:
+	ServerPtr _server;
+	SessionMgrPtr _mgr;
+};
+
+// 回环上的会话: peer 从 ip 连到 acceptor, 接受的一端作为会话 socket.
+// 会话的对端地址即通道端的远端 IP, 两端用不同的回环地址以免互相抢绑.
+// 要 start() 的会话给足 timeout (秒), 免得压测中途被登录超时关掉.
+inline SessionPtr connect(const Manager& mgr, asio::io_context& io, asio::ip::tcp::acceptor& acceptor,
+		asio::ip::tcp::socket& peer, const char* ip, uint32_t id, uint32_t timeout = 0)
+{
+	SessionPtr ss = boost::make_shared<CSession>(mgr.get(), boost::ref(io), timeout);
+	peer.open(asio::ip::tcp::v4());
+	peer.bind(asio::ip::tcp::endpoint(asio::ip::address::from_string(ip), 0));
+	peer.connect(acceptor.local_endpoint());
+	acceptor.accept(ss->socket());
+	ss->id(id);
+	return ss;
+}
+
+}
+
+#ifdef BENCH_COUNT_NEW
+// 统计堆分配的工具在包含本文件前定义 BENCH_COUNT_NEW, 替换全局 operator new 计数
+namespace bench {
+
+static boost::atomic<uint64_t> g_news(0);
+
+// 进程启动以来 operator new 的次数, 前后相减得到一段代码的分配次数
+inline uint64_t news() { return g_news.load(boost::memory_order_relaxed); }
+
+}
+
+// 不内联, 免得编译器在调用处看到 malloc/free 和 new/delete 配对而告警
+__attribute__((noinline)) void* operator new(std::size_t n) throw(std::bad_alloc)
+{
+	bench::g_news.fetch_add(1, boost::memory_order_relaxed);
+	void* p = malloc(n ? n : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) throw()
+{
+	free(p);
+}
+#endif
+
+#endif /* TOOLS_BENCH_HPP_ */
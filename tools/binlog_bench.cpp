@@ -0,0 +1,241 @@
+/*
+ * binlog_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 二进制日志与文本日志对比: 按 CChannel 的写法输出通道的打开, 两端认证读和回显, 关闭共 6 行,
+ * 比较每行的进程 CPU (含异步日志写线程), 墙上时间和落盘字节数. 两种模式各在一个子进程里跑,
+ * 日志等级 TRACE, 文本日志按默认的异步队列写. 最后检查保留上限和预分配失败时退回文本日志.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_LOG_DYN_LINK tools/binlog_bench.cpp src/util/CLogger.cpp \
+ *       src/util/CBinLog.cpp src/util/util.cpp src/util/CCoarseClock.cpp src/net/CTraffic.cpp -o binlog_bench \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: binlog_bench [通道数, 默认 200000] [日志目录, 默认 /tmp/binlog_bench]
+ */
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "net/CTraffic.hpp"
+#include "util/CBinLog.hpp"
+#include "util/CLogger.hpp"
+#include "util/util.hpp"
+
+extern "C"
+{
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+}
+
+static const size_t LINES_PER_CHANNEL = 6;
+static const size_t AUTH_LEN = 12;	// 通道号 + 令牌
+
+static uint64_t nowNs(clockid_t clock)
+{
+	struct timespec ts;
+	::clock_gettime(clock, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 目录下普通文件的个数和总字节数
+static uint64_t dirBytes(const std::string& dir, size_t* files)
+{
+	uint64_t total = 0;
+	*files = 0;
+	boost::filesystem::directory_iterator end;
+	for (boost::filesystem::directory_iterator it(dir); it != end; ++it) {
+		if (boost::filesystem::is_regular_file(it->status())) {
+			total += boost::filesystem::file_size(it->path());
+			(*files)++;
+		}
+	}
+	return total;
+}
+
+// 一条通道从打开到关闭的 6 行, 与 CChannel 的对应语句一致
+static void channelLines(uint32_t id, const boost::asio::ip::udp::endpoint& src,
+		const boost::asio::ip::udp::endpoint& dst, const char* auth, const CTrafficTotal& total)
+{
+	uint32_t src_id = id * 2, dst_id = id * 2 + 1;
+	uint16_t src_port = 20000, dst_port = 20001;
+	std::string src_dir = "src", dst_dir = "dst";
+	boost::posix_time::time_duration td = boost::posix_time::seconds(3725);
+
+	if (CBinLog::enabled())
+		BLOG(TRACE, binlog::FMT_CHANNEL_OPENED) << id << src_id
+				<< src << src_port << dst_port << dst << dst_id;
+	else
+		LOG(TRACE) << "channel[" << id << "] "
+				<< "("<< src_id
+				<< ")["    << src
+				<< " --> " << src_port
+				<< " --> " << dst_port
+				<< " --> " << dst
+				<< "]("    << dst_id << ") opened.";
+
+	for (int up = 0; up < 2; up++) {
+		const boost::asio::ip::udp::endpoint& remote = up ? src : dst;
+		uint16_t port = up ? src_port : dst_port;
+		const std::string& dir = up ? src_dir : dst_dir;
+		if (CBinLog::enabled())
+			BLOG(DEBUG, binlog::FMT_CHANNEL_AUTH_READ) << id << src_id << remote
+					<< port << dst_id << dir << AUTH_LEN
+					<< CBinLog::Hex(auth, AUTH_LEN);
+		else
+			LOG(DEBUG) << "channel[" << id << "] "
+					<< "("		<< src_id
+					<< ")["		<< remote
+					<< " --> "	<< port
+					<< "]("		<< dst_id
+					<< ") " << dir << " read auth[" << AUTH_LEN << "B]: " << util::hex(auth, AUTH_LEN);
+
+		if (CBinLog::enabled())
+			BLOG(INFO, binlog::FMT_CHANNEL_AUTH_ECHO) << id << src_id << remote
+					<< port << dst_id << dir << AUTH_LEN
+					<< CBinLog::Hex(auth, AUTH_LEN);
+		else
+			LOG(INFO) << "channel[" << id << "] "
+					<< "("		<< src_id
+					<< ")["		<< remote
+					<< " <-- "	<< port
+					<< "]("		<< dst_id
+					<< ") " << dir << " echo auth[" << AUTH_LEN << "B]: " << util::hex(auth, AUTH_LEN);
+	}
+
+	if (CBinLog::enabled())
+		BLOG(INFO, binlog::FMT_CHANNEL_CLOSED) << id
+				<< static_cast<int64_t>(td.hours()) << static_cast<int64_t>(td.minutes())
+				<< static_cast<int64_t>(td.seconds())
+				<< total.up_packs << CBinLog::Bytes(total.up_bytes)
+				<< total.down_packs << CBinLog::Bytes(total.down_bytes)
+				<< (total.up_batches > 0 ? total.up_packs / total.up_batches : 0)
+				<< (total.down_batches > 0 ? total.down_packs / total.down_batches : 0);
+	else
+		LOG(INFO) << "channel[" << id << "] closed. takes time: {"
+				<< td.hours() << "h:" << td.minutes() << "m:" << td.seconds() << "s}"
+				<< " | " << total.str();
+}
+
+static int run(size_t n, const std::string& base, bool binary)
+{
+	std::string dir = base + (binary ? "/binary" : "/text");
+	boost::filesystem::remove_all(dir);
+	initLog("binlog_bench", dir, 100, TRACE, 8192, true);
+	if (binary && !CBinLog::init("binlog_bench", dir, 64 * MB, 64 * 1024 * MB)) {
+		printf("binary log init failed\n");
+		return 1;
+	}
+
+	boost::asio::ip::udp::endpoint src(boost::asio::ip::address::from_string("203.0.113.7"), 40001);
+	boost::asio::ip::udp::endpoint dst(boost::asio::ip::address::from_string("198.51.100.9"), 40002);
+	char auth[AUTH_LEN];
+	memset(auth, 0xA5, sizeof(auth));
+	CTrafficTotal total;
+	total.up_packs = 123456;
+	total.up_bytes = 123456 * 1200;
+	total.up_batches = 4000;
+	total.down_packs = 65432;
+	total.down_bytes = 65432 * 1200;
+	total.down_batches = 3000;
+
+	// 文本日志的异步写线程在 finitLog 时排空, 计到结束
+	uint64_t cpu = nowNs(CLOCK_PROCESS_CPUTIME_ID);
+	uint64_t wall = nowNs(CLOCK_MONOTONIC);
+	for (size_t i = 0; i < n; i++)
+		channelLines(static_cast<uint32_t>(i), src, dst, auth, total);
+	CBinLog::finit();
+	finitLog();
+	cpu = nowNs(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+	wall = nowNs(CLOCK_MONOTONIC) - wall;
+
+	size_t files = 0;
+	uint64_t bytes = dirBytes(dir, &files);
+	size_t lines = n * LINES_PER_CHANNEL;
+	printf("%-6s %8zu lines %7.1f cpu ns/line %7.1f wall ns/line %6.1f B/line %8s in %zu files\n",
+			binary ? "binary" : "text", lines, static_cast<double>(cpu) / lines,
+			static_cast<double>(wall) / lines, static_cast<double>(bytes) / lines,
+			util::formatBytes(bytes).c_str(), files);
+	boost::filesystem::remove_all(dir);
+	return 0;
+}
+
+// 保留上限: 1MB 的文件, 上限 4MB, 写满多次滚动后目录里的 .blog 不超过上限.
+// 预分配失败: 单文件大小限制小于文件大小, init 失败并删掉半成品, enabled() 为 false.
+static int check(const std::string& base)
+{
+	std::string dir = base + "/check";
+	boost::filesystem::remove_all(dir);
+	boost::filesystem::remove_all(dir + "_text");
+	initLog("binlog_bench", dir + "_text", 100, TRACE);
+	boost::filesystem::create_directories(dir);
+
+	if (!CBinLog::init("binlog_bench", dir, MB, 4 * MB)) {
+		printf("FAIL binary log init\n");
+		return 1;
+	}
+	boost::asio::ip::udp::endpoint ep(boost::asio::ip::address::from_string("203.0.113.7"), 40001);
+	char auth[AUTH_LEN];
+	memset(auth, 0xA5, sizeof(auth));
+	CTrafficTotal total;
+	for (uint32_t i = 0; i < 100000; i++)
+		channelLines(i, ep, ep, auth, total);
+	CBinLog::finit();
+
+	size_t files = 0;
+	uint64_t bytes = dirBytes(dir, &files);
+	int rc = 0;
+	if (bytes > 4 * MB || files < 3) {
+		printf("FAIL retention: %zu files %s, limit 4MB\n", files, util::formatBytes(bytes).c_str());
+		rc = 1;
+	}
+	else {
+		printf("retention ok: %zu files %s, limit 4MB\n", files, util::formatBytes(bytes).c_str());
+	}
+
+	boost::filesystem::remove_all(dir);
+	boost::filesystem::create_directories(dir);
+	::signal(SIGXFSZ, SIG_IGN);
+	struct rlimit rl;
+	rl.rlim_cur = rl.rlim_max = MB / 2;
+	::setrlimit(RLIMIT_FSIZE, &rl);
+	bool opened = CBinLog::init("binlog_bench", dir, MB, 4 * MB);
+	if (opened || CBinLog::enabled() || dirBytes(dir, &files) != 0 || files != 0) {
+		printf("FAIL fallocate failure: init %d enabled %d files %zu\n", opened, CBinLog::enabled(), files);
+		rc = 1;
+	}
+	else {
+		printf("fallback ok: fallocate failure disables the binary log, no file left\n");
+	}
+
+	finitLog();
+	boost::filesystem::remove_all(dir);
+	boost::filesystem::remove_all(dir + "_text");
+	return rc;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+	std::string base = argc > 2 ? argv[2] : "/tmp/binlog_bench";
+
+	for (int m = 0; m < 3; m++) {
+		pid_t pid = fork();
+		if (pid == 0)
+			return m < 2 ? run(n, base, m == 1) : check(base);
+
+		int status = 0;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * binlog_decoder.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 把二进制日志 (*.blog) 还原成文本日志格式.
+ * 编译: g++ -O2 -Isrc tools/binlog_decoder.cpp src/util/util.cpp -o binlog_decoder
+ * 用法: binlog_decoder FILE...
+ */
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iterator>
+
+#include "util/util.hpp"
+#include "util/CBinLogFormat.hpp"
+
+extern "C"
+{
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+}
+
+static const char* levelName(uint8_t level)
+{
+	static const char* const levels[] = {
+			"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR", "FATAL", "REPORT"
+	};
+	if (level < sizeof(levels) / sizeof(*levels))
+		return levels[level];
+	return "?????";
+}
+
+static std::string timestamp(uint64_t us)
+{
+	time_t secs = us / 1000000;
+	struct tm tm;
+	char buf[32] = "";
+	strftime(buf, sizeof(buf), "%Y%m%d %H:%M:%S", localtime_r(&secs, &tm));
+
+	char frac[16] = "";
+	snprintf(frac, sizeof(frac), ".%06u", static_cast<unsigned>(us % 1000000));
+	return std::string(buf) + frac;
+}
+
+// 解出的记录头
+struct Record
+{
+	uint8_t fmt;
+	uint8_t level;
+	uint32_t tid;
+	uint64_t ts_us;
+	const char* args;
+	const char* end;
+};
+
+// 读一个参数并输出, 越界返回 false
+static bool renderArg(const char*& p, const char* end, std::ostream& out)
+{
+	if (p >= end)
+		return false;
+
+	uint8_t type = *p++;
+	switch (type) {
+	case binlog::ARG_U64:
+	case binlog::ARG_I64:
+	case binlog::ARG_BYTES: {
+		uint64_t v = 0;
+		if (!(p = binlog::getVarint(p, end, v)))
+			return false;
+
+		if (type == binlog::ARG_U64)
+			out << v;
+		else if (type == binlog::ARG_I64)
+			out << binlog::unzigzag(v);
+		else
+			out << util::formatBytes(v);
+		return true;
+	}
+	case binlog::ARG_STR:
+	case binlog::ARG_HEX: {
+		uint64_t n = 0;
+		if (!(p = binlog::getVarint(p, end, n)))
+			return false;
+		if (static_cast<uint64_t>(end - p) < n)
+			return false;
+
+		if (type == binlog::ARG_STR)
+			out.write(p, n);
+		else
+			out << util::to_hex(p, n);
+		p += n;
+		return true;
+	}
+	case binlog::ARG_EP: {
+		uint32_t addr = 0;
+		uint16_t port = 0;
+		if (end - p < static_cast<long>(sizeof(addr) + sizeof(port)))
+			return false;
+		memcpy(&addr, p, sizeof(addr));
+		memcpy(&port, p + sizeof(addr), sizeof(port));
+		p += sizeof(addr) + sizeof(port);
+
+		struct in_addr in;
+		in.s_addr = addr;
+		char ip[INET_ADDRSTRLEN] = "";
+		inet_ntop(AF_INET, &in, ip, sizeof(ip));
+		out << ip << ":" << port;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// 参数读到记录结尾为止, 多出的 {} 原样输出
+static bool renderRecord(const Record& rec, uint32_t pid, std::ostream& out)
+{
+	out << "[P:" << pid << "] [" << timestamp(rec.ts_us) << "] ["
+		<< levelName(rec.level) << "] [#" << rec.tid << "]> ";
+
+	const char* fmt = binlog::format(rec.fmt);
+	if (!fmt) {
+		out << "<unknown format " << static_cast<unsigned>(rec.fmt) << ">" << std::endl;
+		return true;
+	}
+
+	const char* p = rec.args;
+	for (const char* f = fmt; *f; f++) {
+		if (f[0] == '{' && f[1] == '}' && p < rec.end) {
+			if (!renderArg(p, rec.end, out))
+				return false;
+			f++;
+			continue;
+		}
+		out << *f;
+	}
+	out << std::endl;
+	return true;
+}
+
+// 解出 off 处的记录头, 返回记录长度; 0 为文件结尾, -1 为记录损坏
+static long parseRecord(const binlog::FileHeader& fhdr, const std::vector<char>& data, size_t off, Record& rec)
+{
+	binlog::RecordHeader hdr;
+	if (off + sizeof(hdr) > data.size())
+		return 0;
+
+	const char* begin = &data[0] + off;
+	memcpy(&hdr, begin, sizeof(hdr));
+	if (hdr.len == 0)
+		return 0;
+	if (hdr.len < sizeof(hdr) || off + hdr.len > data.size())
+		return -1;
+
+	const char* end = begin + hdr.len;
+	uint64_t tid = 0, ts = 0;
+	const char* p = binlog::getVarint(begin + sizeof(hdr), end, tid);
+	if (!p || !(p = binlog::getVarint(p, end, ts)))
+		return -1;
+
+	rec.fmt = hdr.fmt;
+	rec.level = hdr.level;
+	rec.tid = static_cast<uint32_t>(tid);
+	rec.ts_us = fhdr.start_us + binlog::unzigzag(ts);
+	rec.args = p;
+	rec.end = end;
+	return hdr.len;
+}
+
+static int decode(const char* file)
+{
+	std::ifstream in(file, std::ios::binary);
+	if (!in) {
+		std::cerr << "open " << file << " failed." << std::endl;
+		return 1;
+	}
+
+	std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	binlog::FileHeader fhdr;
+	if (data.size() < sizeof(fhdr)
+		|| memcmp(&data[0], binlog::MAGIC, sizeof(binlog::MAGIC)) != 0) {
+		std::cerr << file << ": not a binary log." << std::endl;
+		return 1;
+	}
+
+	memcpy(&fhdr, &data[0], sizeof(fhdr));
+	if (fhdr.version != binlog::VERSION) {
+		std::cerr << file << ": unsupported version " << fhdr.version << std::endl;
+		return 1;
+	}
+
+	size_t off = sizeof(fhdr);
+	for (;;) {
+		Record rec;
+		long len = parseRecord(fhdr, data, off, rec);
+		if (len == 0)
+			break;	// 文件结尾
+		if (len < 0) {
+			std::cerr << file << ": corrupt record at " << off << std::endl;
+			return 1;
+		}
+
+		if (!renderRecord(rec, fhdr.pid, std::cout))
+			std::cout << " <truncated record>" << std::endl;
+		off += len;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " FILE..." << std::endl;
+		return 1;
+	}
+
+	int rc = 0;
+	for (int i = 1; i < argc; i++)
+		rc |= decode(argv[i]);
+	return rc;
+}
@@ -0,0 +1,130 @@
+/*
+ * channel_mem_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 空闲通道常驻内存: 建 N 条已启动但没有流量的通道, 看每条通道占多少常驻内存.
+ * handler 模式是现在的回调状态机; spawn 模式在每条通道上再挂 4 个空等的栈协程
+ * (原来的 uploader, downloader 和两端的 portExpiredChecker), 近似改造前的开销.
+ * 两种模式各在一个子进程里跑, 互不影响常驻内存. 每条通道占 2 个 fd, 注意 ulimit -n.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_COROUTINES_NO_DEPRECATION_WARNING tools/channel_mem_bench.cpp \
+ *       $(find src/net src/util -name '*.cpp') -o channel_mem_bench \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_coroutine -lboost_context \
+ *       -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: channel_mem_bench [通道数, 默认 2000] [handler|spawn, 默认两种都跑]
+ */
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/log/core.hpp>
+
+#include "net/CChannel.hpp"
+#include "net/CSession.hpp"
+#include "bench.hpp"
+
+extern "C"
+{
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+}
+
+static const int OLD_COROUTINES = 4;	// 改造前每条通道的栈协程数, 不含可选的 displayer
+
+// 原来的协程大多挂在 async_wait 上, 用一个很久以后才到期的定时器代替
+static void idle(asio::io_context& io, asio::yield_context yield)
+{
+	boost::system::error_code ec;
+	asio::steady_timer timer(io);
+	timer.expires_after(boost::asio::chrono::hours(24));
+	timer.async_wait(yield[ec]);
+}
+
+// 建一条空闲通道, spawn 时再挂上原来那几个协程
+static bool open(asio::io_context& io, const SessionPtr& src_ss, const SessionPtr& dst_ss,
+		bool spawn, std::vector<ChannelPtr>& channels)
+{
+	ChannelPtr chann = boost::make_shared<CChannel>(boost::ref(io), channels.size() + 1, 1500, 60, 0, 1, false, false);
+	if (!chann->init(src_ss, dst_ss))
+		return false;
+
+	chann->start();
+	channels.push_back(chann);
+	for (int i = 0; spawn && i < OLD_COROUTINES; i++)
+		asio::spawn(io, boost::bind(idle, boost::ref(io), boost::placeholders::_1));
+	return true;
+}
+
+static int run(size_t n, bool spawn)
+{
+	asio::io_context io;
+	asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0));
+	asio::ip::tcp::socket src_peer(io);
+	asio::ip::tcp::socket dst_peer(io);
+	bench::Manager mgr;
+	SessionPtr src_ss = bench::connect(mgr, io, acceptor, src_peer, "127.0.0.2", 1);
+	SessionPtr dst_ss = bench::connect(mgr, io, acceptor, dst_peer, "127.0.0.3", 2);
+
+	std::vector<ChannelPtr> channels;
+	channels.reserve(n + 1);
+
+	// 第一条通道不计, 单例服务和缓冲池的一次性开销排除在外
+	if (!open(io, src_ss, dst_ss, spawn, channels)) {
+		printf("channel init failed\n");
+		return 1;
+	}
+	bench::pump(io);
+
+	long rss_start = bench::rssKb();
+	for (size_t i = 0; i < n; i++) {
+		if (!open(io, src_ss, dst_ss, spawn, channels)) {
+			printf("channel[%zu] init failed, check ulimit -n\n", i);
+			return 1;
+		}
+	}
+	bench::pump(io);
+	long rss_end = bench::rssKb();
+
+	printf("%-8s %zu idle channels: rss %ld KB -> %ld KB, %.2f KB/channel\n",
+			spawn ? "spawn" : "handler", n, rss_start, rss_end,
+			static_cast<double>(rss_end - rss_start) / n);
+
+	for (size_t i = 0; i < channels.size(); i++)
+		channels[i]->stop();
+	channels.clear();
+	bench::pump(io);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+	boost::log::core::get()->set_logging_enabled(false);	// 每条通道的开关日志会淹没结果
+	if (argc > 2)
+		return run(n, strcmp(argv[2], "spawn") == 0);
+
+	const char* modes[] = { "handler", "spawn" };
+	for (int m = 0; m < 2; m++) {
+		pid_t pid = fork();
+		if (pid == 0)
+			return run(n, m == 1);
+
+		int status = 0;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			printf("%s run failed\n", modes[m]);
+			return 1;
+		}
+	}
+	return 0;
+}
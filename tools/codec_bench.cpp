@@ -0,0 +1,452 @@
+/*
+ * codec_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 控制协议编解码压测: 各应答的布局模板编码 (池化缓冲) 与旧的 new 缓冲 + make_shared<string> 写法对比,
+ * 附带每个应答的 operator new 次数; 各请求包的解码与基线 (3a2eded) 的手写解码对比.
+ * 先校验两种编码逐字节一致、空包体的 GETPROXIES 可以解码. 心跳没有应答, 收心跳见 heartbeat_bench.
+ * 编译: g++ -std=c++98 -O2 -Isrc tools/codec_bench.cpp src/net/CProtocol.cpp src/net/CPktBuf.cpp \
+ *       -o codec_bench -lboost_chrono -lboost_system
+ * 用法: codec_bench [次数, 默认 10000000]
+ */
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+
+#include "net/CProtocol.hpp"
+#define BENCH_COUNT_NEW
+#include "bench.hpp"
+
+extern "C"
+{
+#include <string.h>
+}
+
+using bench::Clock;
+
+// 防止结果被优化掉
+static volatile uint32_t sink = 0;
+
+static TagPktHdr header(uint8_t func)
+{
+	TagPktHdr hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.ucHead1 = HEADER::H1;
+	hdr.ucHead2 = HEADER::H2;
+	hdr.ucPrtVersion = PROTOVERSION::V1;
+	hdr.ucSvrVersion = SVRVERSION::NOENCRYP;
+	hdr.ucFunc = func;
+	return hdr;
+}
+
+static const size_t DIR_ENTRIES = CReqGetProxiesPkt::PAGE_ENTRIES;
+
+// 旧写法的应答编码, 作为对照: new 一块缓冲拼好, 再拷进 make_shared<string>.
+static StringPtr legacyPkt(uint8_t func, const char* body, uint16_t bodylen)
+{
+	TagPktHdr head = header(func);
+	size_t len = sizeof(TagPktHdr) + bodylen;
+	char* buf = new char[len + 1]();
+	memcpy(buf, &head, sizeof(head));
+	memcpy(buf + 6, &bodylen, 2);
+	memcpy(buf + 8, body, bodylen);
+
+	StringPtr pkt = boost::make_shared<std::string>(buf, len);
+	delete[] buf;
+	return pkt;
+}
+
+static StringPtr legacyLogin(uint32_t i)
+{
+	char body[5];
+	body[0] = ERRCODE::SUCCESS;
+	memcpy(body + 1, &i, 4);
+	return legacyPkt(FUNC::RESP::LOGIN, body, sizeof(body));
+}
+
+static StringPtr legacyProxy(uint32_t i)
+{
+	char body[1 + 4 + 4 + 2];
+	uint32_t addr = 0x0100007F;
+	uint16_t port = 8000;
+	body[0] = ERRCODE::SUCCESS;
+	memcpy(body + 1, &i, 4);
+	memcpy(body + 1 + 4, &addr, 4);
+	memcpy(body + 1 + 4 + 4, &port, 2);
+	return legacyPkt(FUNC::RESP::PROXY, body, sizeof(body));
+}
+
+static StringPtr legacyAccess(uint32_t i)
+{
+	char body[4 + 4 + 4 + 2 + 4];
+	uint32_t addr = 0x0100007F, private_addr = 0x0101A8C0;
+	uint16_t port = 8000;
+	memcpy(body, &i, 4);
+	memcpy(body + 4, &i, 4);
+	memcpy(body + 4 + 4, &addr, 4);
+	memcpy(body + 4 + 4 + 4, &port, 2);
+	memcpy(body + 4 + 4 + 4 + 2, &private_addr, 4);
+	return legacyPkt(FUNC::RESP::ACCESS, body, sizeof(body));
+}
+
+static StringPtr legacyStopProxy(uint32_t i)
+{
+	char body[4 + 4 + 2];
+	uint32_t addr = 0x0100007F;
+	uint16_t port = 8000;
+	memcpy(body, &i, 4);
+	memcpy(body + 4, &addr, 4);
+	memcpy(body + 4 + 4, &port, 2);
+	return legacyPkt(FUNC::RESP::STOPPROXY, body, sizeof(body));
+}
+
+// 目录: 旧写法每次请求由会话库拼出 [cnt][条目...] 串, 这里只算编码, 用拼好的串;
+// 新写法的条目直接从会话库共享的快照编码.
+static StringPtr g_dir;
+static StringPtr g_legacy_sessions;
+
+static void buildDir()
+{
+	g_dir = boost::make_shared<std::string>();
+	for (uint32_t id = 1; id <= DIR_ENTRIES; id++) {
+		uint32_t addr = 0x0100007F + id;
+		g_dir->append(reinterpret_cast<const char*>(&id), 4);
+		g_dir->append(reinterpret_cast<const char*>(&addr), 4);
+	}
+	g_legacy_sessions = boost::make_shared<std::string>(1, static_cast<char>(DIR_ENTRIES));
+	g_legacy_sessions->append(*g_dir);
+}
+
+static StringPtr legacyGetProxies(uint32_t)
+{
+	return legacyPkt(FUNC::RESP::GETPROXIES, g_legacy_sessions->data(),
+			static_cast<uint16_t>(g_legacy_sessions->size()));
+}
+
+static PktBufPtr layoutLogin(uint32_t i)
+{
+	CRespLogin resp;
+	resp.error(ERRCODE::SUCCESS);
+	resp.id(i);
+	return resp.serialize(header(FUNC::RESP::LOGIN));
+}
+
+static PktBufPtr layoutProxy(uint32_t i)
+{
+	CRespProxy resp;
+	resp.error(ERRCODE::SUCCESS);
+	resp.udpId(i);
+	resp.udpAddr(0x0100007F);
+	resp.udpPort(8000);
+	return resp.serialize(header(FUNC::RESP::PROXY));
+}
+
+static PktBufPtr layoutAccess(uint32_t i)
+{
+	CRespAccess resp;
+	resp.srcId(i);
+	resp.udpId(i);
+	resp.udpAddr(0x0100007F);
+	resp.udpPort(8000);
+	resp.privateAddr(0x0101A8C0);
+	return resp.serialize(header(FUNC::RESP::ACCESS));
+}
+
+static PktBufPtr layoutStopProxy(uint32_t i)
+{
+	CRespStopProxy resp;
+	resp.udpId(i);
+	resp.udpAddr(0x0100007F);
+	resp.udpPort(8000);
+	return resp.serialize(header(FUNC::RESP::STOPPROXY));
+}
+
+static PktBufPtr layoutGetProxies(uint32_t)
+{
+	CRespGetProxies resp;
+	resp.entries(g_dir, 0, DIR_ENTRIES);
+	return resp.serialize(header(FUNC::RESP::GETPROXIES));
+}
+
+typedef StringPtr (*LegacyEncoder)(uint32_t);
+typedef PktBufPtr (*LayoutEncoder)(uint32_t);
+
+struct Encoder
+{
+	const char* name;
+	LegacyEncoder legacy;
+	LayoutEncoder layout;
+};
+
+static const Encoder ENCODERS[] = {
+	{ "login", legacyLogin, layoutLogin },
+	{ "proxy", legacyProxy, layoutProxy },
+	{ "access", legacyAccess, layoutAccess },
+	{ "stopproxy", legacyStopProxy, layoutStopProxy },
+	{ "getproxies 255", legacyGetProxies, layoutGetProxies },
+};
+static const size_t ENCODER_NUM = sizeof(ENCODERS) / sizeof(ENCODERS[0]);
+
+static bool verify()
+{
+	bool ok = true;
+	for (size_t i = 0; i < ENCODER_NUM; i++) {
+		StringPtr legacy = ENCODERS[i].legacy(42);
+		PktBufPtr pkt = ENCODERS[i].layout(42);
+		if (legacy->size() != pkt->size() || memcmp(legacy->data(), pkt->data(), pkt->size()) != 0) {
+			printf("FAIL %s encoding differs from legacy\n", ENCODERS[i].name);
+			ok = false;
+		}
+	}
+
+	CReqGetProxiesPkt empty;
+	if (!empty.deserialize(header(FUNC::REQ::GETPROXIES), "", 0)) {
+		printf("FAIL empty GETPROXIES body rejected\n");
+		ok = false;
+	}
+
+	CReqGetProxiesPkt with_id;
+	uint32_t id = 42;
+	if (!with_id.deserialize(header(FUNC::REQ::GETPROXIES), reinterpret_cast<const char*>(&id), sizeof(id))
+			|| with_id.uiId != id) {
+		printf("FAIL GETPROXIES id not decoded\n");
+		ok = false;
+	}
+	return ok;
+}
+
+// 耗时和平均每个应答的 operator new 次数, 发送缓冲池已由 verify 热过
+template <typename Encode>
+static void timeEncode(const char* name, const char* how, Encode encode, size_t n)
+{
+	uint64_t news = bench::news();
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < n; i++)
+		sink += encode(static_cast<uint32_t>(i))->size();
+	double ns = bench::nsPerOp(start, n);
+	printf("encode %-16s (%s) %8.1f ns/op %6.3f news/op\n", name, how, ns,
+			static_cast<double>(bench::news() - news) / n);
+}
+
+static void benchEncode(size_t n)
+{
+	for (size_t i = 0; i < ENCODER_NUM; i++) {
+		timeEncode(ENCODERS[i].name, "legacy", ENCODERS[i].legacy, n);
+		timeEncode(ENCODERS[i].name, "layout", ENCODERS[i].layout, n);
+	}
+}
+
+// 基线 (3a2eded) 的手写请求解码, 作为对照: 传入整个包 (包头 + 包体), 长度检查照搬原写法
+struct LegacyLoginReq
+{
+	LegacyLoginReq() : uctype(0), uiPrivateAddr(0) {}
+
+	bool deserialize(const char* p, const size_t n)
+	{
+		if (n < 5)
+			return false;
+
+		memcpy(&header, p, sizeof(TagPktHdr));
+		p += sizeof(TagPktHdr);
+
+		size_t len = p[0];
+		if (n < len + 5)
+		{
+			return false;
+		}
+
+		szGuid.assign(p + 1, len);
+		memcpy(&uiPrivateAddr, p + 1 + len, 4);
+
+		if (header.usBodyLen == 1 + len + 4)
+			uctype = 3;//ANYONE
+		else if(header.usBodyLen > 1 + len + 4)
+			uctype = p[1+len+4];
+		else
+			uctype = 0;
+		return true;
+	}
+
+	TagPktHdr header;
+	uint8_t uctype;
+	std::string szGuid;
+	uint32_t uiPrivateAddr;
+};
+
+struct LegacyProxyReq
+{
+	LegacyProxyReq() : uiId(0), uiDstId(0) {}
+
+	bool deserialize(const char* p, const size_t n)
+	{
+		if (n < 9)
+			return false;
+
+		memcpy(&header, p, sizeof(TagPktHdr));
+		p += sizeof(TagPktHdr);
+
+		memcpy(&uiId, p, 4);
+		memcpy(&uiDstId, p + 4, 4);
+		size_t len = p[8];
+		if (n < len + 9)
+		{
+			return false;
+		}
+		szGameId.assign(p + 9, len);
+		return true;
+	}
+
+	TagPktHdr header;
+	uint32_t uiId;
+	uint32_t uiDstId;
+	std::string szGameId;
+};
+
+struct LegacyGetProxiesReq
+{
+	LegacyGetProxiesReq() : uiId(0) {}
+
+	bool deserialize(const char* p, const size_t)
+	{
+		memcpy(&header, p, sizeof(TagPktHdr));
+		p += sizeof(TagPktHdr);
+
+		memcpy(&uiId, p, 4);
+		return true;
+	}
+
+	TagPktHdr header;
+	uint32_t uiId;
+};
+
+// 一个完整的请求包, 旧解码读整包, 新解码只读包体
+struct Request
+{
+	Request(uint8_t func, const char* body, uint16_t len) {
+		hdr = header(func);
+		hdr.usBodyLen = len;
+		pkt.assign(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+		pkt.append(body, len);
+	}
+	const char* body() const { return pkt.data() + sizeof(TagPktHdr); }
+
+	TagPktHdr hdr;
+	std::string pkt;
+};
+
+static void report(const char* name, const char* how, Clock::time_point start, uint64_t news, size_t n)
+{
+	double ns = bench::nsPerOp(start, n);
+	printf("decode %-16s (%s) %8.1f ns/op %6.3f news/op\n", name, how, ns,
+			static_cast<double>(bench::news() - news) / n);
+}
+
+static bool benchDecode(size_t n)
+{
+	// 代理请求: id, 目的 id, 游戏 id
+	char proxy_body[64];
+	uint32_t id = 1, dst = 2;
+	const char game[] = "game-0001";
+	memcpy(proxy_body, &id, 4);
+	memcpy(proxy_body + 4, &dst, 4);
+	proxy_body[8] = static_cast<char>(sizeof(game) - 1);
+	memcpy(proxy_body + 9, game, sizeof(game) - 1);
+	Request proxy(FUNC::REQ::PROXY, proxy_body, 9 + sizeof(game) - 1);
+
+	// 登录请求: guid, 内网地址, 类型
+	char login_body[64];
+	const char guid[] = "0123456789abcdef0123456789abcdef";
+	uint32_t addr = 0x0101A8C0;
+	login_body[0] = static_cast<char>(sizeof(guid) - 1);
+	memcpy(login_body + 1, guid, sizeof(guid) - 1);
+	memcpy(login_body + 1 + sizeof(guid) - 1, &addr, 4);
+	login_body[1 + sizeof(guid) - 1 + 4] = SESSIONTYPE::CLIENT;
+	Request login(FUNC::REQ::LOGIN, login_body, 1 + sizeof(guid) - 1 + 4 + 1);
+
+	// 旧解码总是读 4 字节 id, 对照时两边都用带 id 的包体
+	Request getproxies(FUNC::REQ::GETPROXIES, reinterpret_cast<const char*>(&id), 4);
+
+	{
+		LegacyLoginReq a;
+		CReqLoginPkt b;
+		LegacyProxyReq c;
+		CReqProxyPkt d;
+		LegacyGetProxiesReq e;
+		CReqGetProxiesPkt f;
+		if (!a.deserialize(login.pkt.data(), login.pkt.size()) || !b.deserialize(login.hdr, login.body(), login.hdr.usBodyLen)
+				|| a.szGuid != b.szGuid || a.uiPrivateAddr != b.uiPrivateAddr || a.uctype != b.uctype
+				|| !c.deserialize(proxy.pkt.data(), proxy.pkt.size()) || !d.deserialize(proxy.hdr, proxy.body(), proxy.hdr.usBodyLen)
+				|| c.uiId != d.uiId || c.uiDstId != d.uiDstId || c.szGameId != d.szGameId
+				|| !e.deserialize(getproxies.pkt.data(), getproxies.pkt.size())
+				|| !f.deserialize(getproxies.hdr, getproxies.body(), getproxies.hdr.usBodyLen) || e.uiId != f.uiId) {
+			printf("FAIL legacy and layout decoders disagree\n");
+			return false;
+		}
+	}
+
+	uint64_t news = bench::news();
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		LegacyLoginReq pkt;
+		sink += pkt.deserialize(login.pkt.data(), login.pkt.size()) ? pkt.uctype : 0;
+	}
+	report("login", "legacy", start, news, n);
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		CReqLoginPkt pkt;
+		sink += pkt.deserialize(login.hdr, login.body(), login.hdr.usBodyLen) ? pkt.uctype : 0;
+	}
+	report("login", "layout", start, news, n);
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		LegacyProxyReq pkt;
+		sink += pkt.deserialize(proxy.pkt.data(), proxy.pkt.size()) ? pkt.uiDstId : 0;
+	}
+	report("proxy", "legacy", start, news, n);
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		CReqProxyPkt pkt;
+		sink += pkt.deserialize(proxy.hdr, proxy.body(), proxy.hdr.usBodyLen) ? pkt.uiDstId : 0;
+	}
+	report("proxy", "layout", start, news, n);
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		LegacyGetProxiesReq pkt;
+		sink += pkt.deserialize(getproxies.pkt.data(), getproxies.pkt.size()) ? pkt.uiId : 0;
+	}
+	report("getproxies", "legacy", start, news, n);
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		CReqGetProxiesPkt pkt;
+		sink += pkt.deserialize(getproxies.hdr, getproxies.body(), getproxies.hdr.usBodyLen) ? pkt.uiId : 0;
+	}
+	report("getproxies", "layout", start, news, n);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+	buildDir();
+	if (!verify())
+		return 1;
+
+	benchEncode(n);
+	return benchDecode(n) ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*
+ * demux_rebind_test.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 共享端口分发: 源端换端口 (NAT 重映射) 后凭通道号前缀和带令牌的认证包重新绑定;
+ * 同IP的邻居不带令牌既不能抢先绑定, 也不能抢走已打开的一端.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_COROUTINES_NO_DEPRECATION_WARNING tools/demux_rebind_test.cpp \
+ *       $(find src/net src/util -name '*.cpp') -o demux_rebind_test \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_coroutine -lboost_context \
+ *       -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: demux_rebind_test, 全部通过返回 0
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <boost/make_shared.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include "net/CChannel.hpp"
+#include "net/CSession.hpp"
+#include "net/CUdpDemux.hpp"
+#include "bench.hpp"
+
+extern "C"
+{
+#include <string.h>
+#include <unistd.h>
+}
+
+static uint32_t chann_id = 0;
+static uint64_t chann_token = 0;
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	std::cout << (ok ? "ok   " : "FAIL ") << what << std::endl;
+	if (!ok)
+		failures++;
+}
+
+// 驱动分发协程一段时间
+static void pump(asio::io_context& io)
+{
+	bench::pump(io, 50, 1000);
+}
+
+static std::string prefixed(const std::string& payload)
+{
+	std::string pkt(sizeof(chann_id), '\0');
+	memcpy(&pkt[0], &chann_id, sizeof(chann_id));
+	return pkt + payload;
+}
+
+// 认证包: 通道号前缀 + 令牌 + 任意内容
+static std::string auth(uint64_t token)
+{
+	std::string body(sizeof(token), '\0');
+	memcpy(&body[0], &token, sizeof(token));
+	return prefixed(body + "auth");
+}
+
+class CPeer
+{
+public:
+	CPeer(asio::io_context& io, const char* ip, const asio::ip::udp::endpoint& server)
+	: _socket(io, asio::ip::udp::endpoint(asio::ip::address::from_string(ip), 0))
+	, _server(server) {
+		_socket.non_blocking(true);
+	}
+
+	void send(const std::string& data) {
+		_socket.send_to(asio::buffer(data), _server);
+	}
+
+	// 驱动 io 读一个数据报, 超时返回空
+	std::string recv(asio::io_context& io) {
+		char buf[1500];
+		asio::ip::udp::endpoint from;
+		boost::system::error_code ec;
+		for (int i = 0; i < 200; i++) {
+			size_t bytes = _socket.receive_from(asio::buffer(buf), from, 0, ec);
+			if (!ec)
+				return std::string(buf, bytes);
+
+			io.poll();
+			io.restart();
+			usleep(1000);
+		}
+		return std::string();
+	}
+
+private:
+	asio::ip::udp::socket _socket;
+	asio::ip::udp::endpoint _server;
+};
+
+int main()
+{
+	asio::io_context io;
+	std::vector<std::string> ips(1, "127.0.0.1");
+	CUdpDemux& demux = asio::use_service<CUdpDemux>(io);
+	if (!demux.init(ips, 1, 1500)) {
+		std::cout << "udp demux init failed" << std::endl;
+		return 1;
+	}
+	asio::ip::udp::endpoint server = demux.localEndpoint(0);
+
+	asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0));
+	asio::ip::tcp::socket src_peer(io);
+	asio::ip::tcp::socket dst_peer(io);
+	bench::Manager mgr;
+	SessionPtr src_ss = bench::connect(mgr, io, acceptor, src_peer, "127.0.0.2", 1);
+	SessionPtr dst_ss = bench::connect(mgr, io, acceptor, dst_peer, "127.0.0.3", 2);
+
+	// 与 CSessionMgr::createChannel 一样先在通道表登记, 分发器按前缀经通道表查找
+	CChannel::Table table;
+	chann_id = table.reserve();
+	ChannelPtr chann = boost::make_shared<CChannel>(boost::ref(io), chann_id, 1500, 0, 0, 1, false, true);
+	table.set(chann_id, chann);
+	chann->registered(&table);
+	if (!chann->init(src_ss, dst_ss)) {
+		std::cout << "channel init failed" << std::endl;
+		return 1;
+	}
+	chann->start();
+	chann_token = chann->token();
+	pump(io);
+
+	CPeer src(io, "127.0.0.2", server);
+	CPeer dst(io, "127.0.0.3", server);
+	CPeer moved(io, "127.0.0.2", server);
+	CPeer neighbour(io, "127.0.0.3", server);
+	CPeer stranger(io, "127.0.0.4", server);
+
+	// 同IP的邻居 (CGNAT) 知道通道号也猜不到令牌, 不能抢先绑定
+	neighbour.send(prefixed("auth"));
+	pump(io);
+	check(neighbour.recv(io).empty(), "first bind without token dropped");
+
+	neighbour.send(auth(chann_token + 1));
+	pump(io);
+	check(neighbour.recv(io).empty(), "first bind with wrong token dropped");
+
+	// 两端认证
+	dst.send(auth(chann_token));
+	pump(io);
+	check(dst.recv(io) == auth(chann_token), "dst auth echoed");
+
+	src.send(auth(chann_token));
+	pump(io);
+	check(src.recv(io) == auth(chann_token), "src auth echoed");
+
+	src.send("payload-1");
+	pump(io);
+	check(dst.recv(io) == "payload-1", "src --> dst forwarded");
+
+	// 换端口后不带前缀的数据被丢弃
+	moved.send("payload-2");
+	pump(io);
+	check(dst.recv(io).empty(), "unprefixed packet from new port dropped");
+
+	// 其它IP带令牌也不能抢绑
+	stranger.send(auth(chann_token));
+	pump(io);
+	check(stranger.recv(io).empty(), "token from foreign ip dropped");
+
+	// 同IP换端口不带令牌, 不能抢走已打开的一端
+	moved.send(prefixed("auth"));
+	pump(io);
+	check(moved.recv(io).empty(), "rebind without token dropped");
+
+	src.send("payload-2b");
+	pump(io);
+	check(dst.recv(io) == "payload-2b", "src still forwarded after failed rebind");
+
+	// 换端口后带令牌认证, 重新绑定
+	moved.send(auth(chann_token));
+	pump(io);
+	check(moved.recv(io) == auth(chann_token), "rebind auth echoed to new port");
+
+	moved.send("payload-3");
+	pump(io);
+	check(dst.recv(io) == "payload-3", "new port --> dst forwarded");
+
+	dst.send("payload-4");
+	pump(io);
+	check(moved.recv(io) == "payload-4", "dst --> new port forwarded");
+	check(src.recv(io).empty(), "old port receives nothing");
+
+	src.send("payload-5");
+	pump(io);
+	check(dst.recv(io).empty(), "old port no longer forwarded");
+
+	chann->stop();
+	chann.reset();
+	pump(io);
+
+	std::cout << (failures ? "FAILED" : "PASSED") << std::endl;
+	return failures ? 1 : 0;
+}
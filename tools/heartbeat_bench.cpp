@@ -0,0 +1,131 @@
+/*
+ * heartbeat_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 心跳流水线的读次数: 客户端在回环上一次写出 depth 个心跳, 会话按 async_read_some 收,
+ * 用 CWorkerTraffic::recv() 的读次数和帧数算每条消息的读系统调用.
+ * split 模式把每批最后一帧拆成两次写, 验证半帧留到下次读再拼.
+ * 改造前每帧先读包头再读包体, 每条消息至少一次 recv.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_COROUTINES_NO_DEPRECATION_WARNING tools/heartbeat_bench.cpp \
+ *       $(find src/net src/util -name '*.cpp') -o heartbeat_bench \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_coroutine -lboost_context \
+ *       -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: heartbeat_bench [每种深度的心跳数, 默认 100000]
+ */
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include <boost/asio/write.hpp>
+#include <boost/log/core.hpp>
+
+#include "bench.hpp"
+#include "net/CProtocol.hpp"
+#include "net/CTraffic.hpp"
+
+extern "C"
+{
+#include <string.h>
+}
+
+using bench::Clock;
+
+static const uint32_t LOGIN_TIMEOUT = 3600;
+
+// depth 个连续的心跳帧
+static std::string heartbeats(size_t depth)
+{
+	TagPktHdr hdr;
+	bzero(&hdr, sizeof(hdr));
+	hdr.ucHead1 = HEADER::H1;
+	hdr.ucHead2 = HEADER::H2;
+	hdr.ucSvrVersion = SVRVERSION::NOENCRYP;
+	hdr.ucFunc = FUNC::REQ::HEARTBEAT;
+
+	std::string s;
+	for (size_t i = 0; i < depth; i++)
+		s.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	return s;
+}
+
+// 跑到会话收齐 target 帧, 连续空转说明会话停了或丢了数据
+static bool drain(asio::io_context& io, CRecvStats& stats, uint64_t target)
+{
+	for (int idle = 0; stats.frames.get() < target; ) {
+		uint64_t before = stats.frames.get();
+		bench::pump(io);
+		idle = stats.frames.get() != before ? 0 : idle + 1;
+		if (idle > 10000)
+			return false;
+	}
+	return true;
+}
+
+static bool run(const bench::Manager& mgr, asio::io_context& io, asio::ip::tcp::acceptor& acceptor,
+		size_t n, size_t depth, bool split)
+{
+	CRecvStats& stats = asio::use_service<CWorkerTraffic>(io).recv();
+	asio::ip::tcp::socket peer(io);
+	SessionPtr ss = bench::connect(mgr, io, acceptor, peer, "127.0.0.2", 1, LOGIN_TIMEOUT);
+	ss->start();
+	bench::pump(io);
+
+	std::string batch = heartbeats(depth);
+	size_t head = split ? batch.size() - sizeof(TagPktHdr) / 2 : batch.size();
+	uint64_t reads = stats.reads.get();
+	uint64_t frames = stats.frames.get();
+	uint64_t sent = 0;
+
+	Clock::time_point start = Clock::now();
+	while (sent < n) {
+		asio::write(peer, asio::buffer(batch.data(), head));
+		if (split) {
+			// 前一半先到, 会话读到半帧后再补上剩下的
+			bench::pump(io);
+			asio::write(peer, asio::buffer(batch.data() + head, batch.size() - head));
+		}
+		sent += depth;
+		if (!drain(io, stats, frames + sent)) {
+			printf("depth %zu: session stalled at %llu of %llu frames\n", depth,
+					static_cast<unsigned long long>(stats.frames.get() - frames),
+					static_cast<unsigned long long>(sent));
+			return false;
+		}
+	}
+	double ns = bench::nsPerOp(start, sent);
+
+	reads = stats.reads.get() - reads;
+	frames = stats.frames.get() - frames;
+	printf("depth %4zu%s %8llu frames %8llu reads %7.2f frames/read %6.3f reads/frame %7.1f ns/frame\n",
+			depth, split ? " split" : "      ",
+			static_cast<unsigned long long>(frames), static_cast<unsigned long long>(reads),
+			static_cast<double>(frames) / reads, static_cast<double>(reads) / frames, ns);
+
+	ss->stop();
+	ss.reset();
+	bench::pump(io);
+	return frames == sent;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+	boost::log::core::get()->set_logging_enabled(false);
+
+	bench::Manager mgr;
+	asio::io_context io;
+	asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0));
+
+	// 512 个心跳正好占满一次读的空间
+	const size_t depths[] = { 1, 8, 64, 512 };
+	for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+		size_t total = std::max(n / depths[i], static_cast<size_t>(1)) * depths[i];
+		if (!run(mgr, io, acceptor, total, depths[i], false) || !run(mgr, io, acceptor, total, depths[i], true))
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * hex_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 十六进制转储压测: 查表编码的 util::to_hex / util::hex 与原来逐字节 ostringstream + setw 的写法对比.
+ * 长度覆盖控制包, 一个 MTU 的认证包, 255 条和 5 万条的 GETPROXIES 应答.
+ * 先校验各写法输出一致.
+ * 编译: g++ -std=c++98 -O2 -Isrc tools/hex_bench.cpp -o hex_bench -lboost_chrono -lboost_system
+ * 用法: hex_bench [每种长度编码的总字节数 MB, 默认 64]
+ */
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/chrono.hpp>
+
+#include "util/util.hpp"
+
+typedef boost::chrono::steady_clock Clock;
+
+// 改造前的 util::to_hex
+static std::string legacyHex(const char* pbuf, const size_t len)
+{
+	std::ostringstream out;
+	out << std::hex;
+	for (size_t i = 0; i < len; i++)
+		out << std::setfill('0') << std::setw(2) << (static_cast<short>(pbuf[i]) & 0xff) << " ";
+	return out.str();
+}
+
+// 日志里的用法: 流式写入记录流
+static std::string streamHex(const char* pbuf, const size_t len)
+{
+	std::ostringstream out;
+	out << util::hex(pbuf, len);
+	return out.str();
+}
+
+static std::string tableHex(const char* pbuf, const size_t len)
+{
+	return util::to_hex(pbuf, len);
+}
+
+// 调用方缓冲, 不经过 std::string
+static std::vector<char> out_buf;
+static size_t bufferHex(const char* pbuf, const size_t len)
+{
+	return util::to_hex(pbuf, len, &out_buf[0]);
+}
+
+// 防止结果被优化掉
+static volatile size_t sink = 0;
+
+struct Case
+{
+	const char* name;
+	size_t len;
+};
+
+static const Case cases[] = {
+	{ "control packet", 26 },
+	{ "auth datagram", 1500 },
+	{ "getproxies 255", 8 + 1 + 255 * 8 + 4 },
+	{ "getproxies 50k", 8 + 1 + 50000 * 8 },
+};
+
+static void report(const char* impl, Clock::time_point start, size_t iters, size_t len, double base)
+{
+	double ns = static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count()) / iters;
+	printf("  %-14s %12.1f ns/call %7.2f ns/byte", impl, ns, ns / len);
+	if (base > 0)
+		printf("  x%.1f", base / ns);
+	printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+	size_t total = (argc > 1 ? strtoul(argv[1], NULL, 10) : 64) << 20;
+
+	std::string data(cases[sizeof(cases) / sizeof(cases[0]) - 1].len, '\0');
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<char>(i * 131 + 7);
+	out_buf.resize(data.size() * 3);
+
+	std::string expect = legacyHex(data.data(), data.size());
+	if (tableHex(data.data(), data.size()) != expect || streamHex(data.data(), data.size()) != expect) {
+		printf("FAIL table encoder output differs from legacy\n");
+		return 1;
+	}
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		size_t len = cases[c].len;
+		size_t iters = std::max<size_t>(total / len, 10);
+		printf("%s (%zu B, %zu calls)\n", cases[c].name, len, iters);
+
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < iters; i++)
+			sink += legacyHex(data.data(), len).size();
+		double base = static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count()) / iters;
+		report("ostringstream", start, iters, len, 0);
+
+		start = Clock::now();
+		for (size_t i = 0; i < iters; i++)
+			sink += tableHex(data.data(), len).size();
+		report("to_hex", start, iters, len, base);
+
+		start = Clock::now();
+		for (size_t i = 0; i < iters; i++)
+			sink += bufferHex(data.data(), len);
+		report("to_hex(out)", start, iters, len, base);
+
+		start = Clock::now();
+		for (size_t i = 0; i < iters; i++)
+			sink += streamHex(data.data(), len).size();
+		report("stream hex", start, iters, len, base);
+	}
+	return 0;
+}
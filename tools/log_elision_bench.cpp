@@ -0,0 +1,159 @@
+/*
+ * log_elision_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 日志等级过滤的单请求 CPU: 按 CSession 的写法走一遍登录和代理请求 (读包 TRACE 十六进制,
+ * 解码, INFO 行, 编码应答, 写包 TRACE 十六进制), 对比三种 LOG:
+ *   old   改造前的 BOOST_LOG_STREAM_SEV, 每条语句都要 open_record 再被 sink 过滤掉
+ *   new   现在的 LOG, 先比较 gLogLevel, 不打开记录
+ *   floor 编译期下限 LOG_MIN_LEVEL=WARNING, 低于它的语句整条编译掉 (仅 warning 等级下可比)
+ * 日志按 initLog 写到 /tmp/log_elision_bench, info 等级下 INFO 行照常落盘.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_LOG_DYN_LINK tools/log_elision_bench.cpp src/util/CLogger.cpp \
+ *       src/util/util.cpp src/util/CCoarseClock.cpp src/net/CProtocol.cpp src/net/CPktBuf.cpp -o log_elision_bench \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: log_elision_bench [请求数, 默认 1000000] [warning|info, 默认 warning]
+ */
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/chrono.hpp>
+#include <boost/chrono/thread_clock.hpp>
+
+#include "net/CProtocol.hpp"
+#include "util/CLogger.hpp"
+#include "util/util.hpp"
+
+extern "C"
+{
+#include <string.h>
+}
+
+typedef boost::chrono::thread_clock Clock;
+
+// 改造前的宏
+#define OLD_LOG(level)  BOOST_LOG_STREAM_SEV(logger::get(), level)
+#define OLD_LOGF(level) OLD_LOG(level) << "[" << __FILE__ << ":" << __FUNCTION__ << "():" << __LINE__ << "] >> "
+
+static TagPktHdr header(uint8_t func, uint16_t body_len)
+{
+	TagPktHdr hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.ucHead1 = HEADER::H1;
+	hdr.ucHead2 = HEADER::H2;
+	hdr.ucPrtVersion = PROTOVERSION::V1;
+	hdr.ucSvrVersion = SVRVERSION::NOENCRYP;
+	hdr.ucFunc = func;
+	hdr.usBodyLen = body_len;
+	return hdr;
+}
+
+struct Request
+{
+	std::string login;	// 含包头
+	std::string proxy;
+};
+
+static Request makeRequest()
+{
+	Request req;
+	const char guid[] = "0123456789abcdef0123456789abcdef";
+	uint32_t addr = 0x0101A8C0;
+	std::string body(1, static_cast<char>(sizeof(guid) - 1));
+	body.append(guid, sizeof(guid) - 1);
+	body.append(reinterpret_cast<const char*>(&addr), 4);
+	body.append(1, static_cast<char>(SESSIONTYPE::CLIENT));
+	TagPktHdr hdr = header(FUNC::REQ::LOGIN, body.size());
+	req.login.assign(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	req.login += body;
+
+	uint32_t id = 1, dst = 2;
+	const char game[] = "game-0001";
+	body.assign(reinterpret_cast<const char*>(&id), 4);
+	body.append(reinterpret_cast<const char*>(&dst), 4);
+	body.append(1, static_cast<char>(sizeof(game) - 1));
+	body.append(game, sizeof(game) - 1);
+	hdr = header(FUNC::REQ::PROXY, body.size());
+	req.proxy.assign(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+	req.proxy += body;
+	return req;
+}
+
+// 一次登录加一次代理, 日志语句与 CSession::onFrame/onReqLogin/onReqProxy/onWriteComplete 一致
+#define REQUEST_PATH(NAME, L, LF) \
+static uint32_t NAME(const Request& req, uint32_t sid) \
+{ \
+	uint32_t sum = 0; \
+	const TagPktHdr* hdr = reinterpret_cast<const TagPktHdr*>(req.login.data()); \
+	L(TRACE) << "session[" << sid << "] read(#REQ_LOGIN#): " << util::hex(req.login); \
+	CReqLoginPkt login; \
+	if (login.deserialize(*hdr, req.login.data() + sizeof(TagPktHdr), hdr->usBodyLen)) { \
+		L(INFO) << "session[" << sid << "] (client) <" << login.szGuid << "> login success."; \
+		CRespLogin resp; \
+		resp.error(ERRCODE::SUCCESS); \
+		resp.id(sid); \
+		PktBufPtr msg = resp.serialize(login.header); \
+		L(TRACE) << "session[" << sid << "] write(#RESP_LOGIN#): " << util::hex(msg->data(), msg->size()); \
+		sum += msg->size(); \
+	} \
+	hdr = reinterpret_cast<const TagPktHdr*>(req.proxy.data()); \
+	L(TRACE) << "session[" << sid << "] read(#REQ_PROXY#): " << util::hex(req.proxy); \
+	CReqProxyPkt proxy; \
+	if (proxy.deserialize(*hdr, req.proxy.data() + sizeof(TagPktHdr), hdr->usBodyLen)) { \
+		LF(INFO) << "session[" << sid << "] request proxy destination[" << proxy.uiDstId << "]"; \
+		CRespAccess resp; \
+		resp.srcId(sid); \
+		resp.udpId(sid); \
+		resp.udpAddr(0x0100007F); \
+		resp.udpPort(8000); \
+		PktBufPtr msg = resp.serialize(proxy.header); \
+		L(TRACE) << "session[" << sid << "] write(#RESP_ACCESS#): " << util::hex(msg->data(), msg->size()); \
+		sum += msg->size(); \
+	} \
+	return sum; \
+}
+
+REQUEST_PATH(requestOld, OLD_LOG, OLD_LOGF)
+REQUEST_PATH(requestNew, LOG, LOGF)
+
+// LOG_ENABLED 在展开处取 LOG_MIN_LEVEL, 换个下限再展开一份
+#undef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL WARNING
+REQUEST_PATH(requestFloor, LOG, LOGF)
+#undef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL TRACE
+
+typedef uint32_t (*RequestFn)(const Request&, uint32_t);
+
+// 防止结果被优化掉
+static volatile uint32_t sink = 0;
+
+static void bench(const char* name, RequestFn fn, const Request& req, size_t n)
+{
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < n; i++)
+		sink += fn(req, i);
+	double ns = static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count());
+	printf("%-6s %8.1f ns cpu/request\n", name, ns / n);
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	bool info = argc > 2 && strcmp(argv[2], "info") == 0;
+
+	initLog("log_elision_bench", "/tmp/log_elision_bench", 100, info ? INFO : WARNING);
+	Request req = makeRequest();
+
+	printf("print level %s, login + proxy per request\n", info ? "info" : "warning");
+	bench("old", requestOld, req, n);
+	bench("new", requestNew, req, n);
+	if (!info)
+		bench("floor", requestFloor, req, n);
+
+	finitLog();
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * login_storm_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 登录风暴: 多个线程同时登录 5 万个客户端 (其中一部分 guid 重复, 应被拒绝), 再全部断开.
+ * 两种 guid 去重写法, 会话表都是 CSlabTable, 只比 guid 这一步:
+ *   set   原来的单锁 CSafeSet<std::string> 先占 guid, 分配 id 失败再回滚
+ *   index 现在 CSessionMgr 的 GuidIndex, 用会话登录时算好哈希的 key 分段登记 guid --> 会话, 注销复用同一个 key
+ * 校验两种写法接受的登录数都等于不重复的 guid 数.
+ * 编译: g++ -std=c++98 -O2 -Isrc tools/login_storm_bench.cpp -o login_storm_bench \
+ *       -lboost_thread -lboost_chrono -lboost_system -lpthread
+ * 用法: login_storm_bench [客户端数, 默认 50000] [线程数, 默认 8] [轮数, 默认 10]
+ */
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+
+#include "util/CSafeSet.hpp"
+#include "util/CShardedMap.hpp"
+#include "util/CSlabTable.hpp"
+
+typedef boost::chrono::steady_clock Clock;
+
+static const size_t DUP_EVERY = 20;	// 每 20 个客户端有一个重复前面的 guid, 模拟断线重连抢登
+
+struct Session
+{
+	Session() : key(""), id(0) {}
+
+	std::string guid;
+	CHashedString key;	// 同 CSession::guidKey, 在 onReqLogin 收到 guid 时算好, 不计入登录耗时
+	uint32_t id;
+};
+typedef boost::shared_ptr<Session> SessionPtr;
+typedef boost::weak_ptr<Session> SessionWptr;
+typedef CSlabTable<Session> SessionTable;
+
+// 改造前的 onSessionLogin / 关闭
+class CSetLogin
+{
+public:
+	bool login(const SessionPtr& ss) {
+		if (!_guid_set.insert(ss->guid))
+			return false;
+
+		uint32_t id = _table.reserve();
+		if (!id) {
+			_guid_set.remove(ss->guid);
+			return false;
+		}
+		_table.set(id, ss);
+		ss->id = id;
+		return true;
+	}
+
+	void logout(const SessionPtr& ss) {
+		_table.remove(ss->id);
+		_guid_set.remove(ss->guid);
+	}
+
+private:
+	CSafeSet<std::string> _guid_set;
+	SessionTable _table;
+};
+
+class CIndexLogin
+{
+public:
+	bool login(const SessionPtr& ss) {
+		uint32_t id = _table.reserve();
+		if (!id)
+			return false;
+
+		if (!_guid_index.insert(ss->key, ss)) {
+			_table.remove(id);
+			return false;
+		}
+		_table.set(id, ss);
+		ss->id = id;
+		return true;
+	}
+
+	void logout(const SessionPtr& ss) {
+		_table.remove(ss->id);
+		_guid_index.remove(ss->key);
+	}
+
+private:
+	CShardedMap<CHashedString, SessionWptr, CHashedString::Hash> _guid_index;
+	SessionTable _table;
+};
+
+template <typename Login>
+static void storm(Login* mgr, std::vector<SessionPtr>* clients, std::vector<char>* accepted,
+		size_t nthreads, size_t tid, boost::atomic<size_t>* ok)
+{
+	size_t n = 0;
+	for (size_t i = tid; i < clients->size(); i += nthreads) {
+		(*accepted)[i] = mgr->login((*clients)[i]);
+		n += (*accepted)[i];
+	}
+	*ok += n;
+}
+
+template <typename Login>
+static void disconnect(Login* mgr, std::vector<SessionPtr>* clients, std::vector<char>* accepted,
+		size_t nthreads, size_t tid)
+{
+	for (size_t i = tid; i < clients->size(); i += nthreads) {
+		if ((*accepted)[i])
+			mgr->logout((*clients)[i]);
+	}
+}
+
+static double elapsedNs(Clock::time_point start)
+{
+	return static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+template <typename Login>
+static bool bench(const char* name, size_t nthreads, size_t rounds, size_t unique,
+		std::vector<SessionPtr>& clients)
+{
+	Login mgr;
+	std::vector<char> accepted(clients.size());
+	double login_ns = 0, logout_ns = 0;
+
+	for (size_t r = 0; r < rounds; r++) {
+		boost::atomic<size_t> ok(0);
+		boost::thread_group threads;
+		Clock::time_point start = Clock::now();
+		for (size_t t = 0; t < nthreads; t++)
+			threads.create_thread(boost::bind(storm<Login>, &mgr, &clients, &accepted, nthreads, t, &ok));
+		threads.join_all();
+		login_ns += elapsedNs(start);
+
+		if (ok.load() != unique) {
+			printf("FAIL %s round %zu accepted %zu logins, expect %zu\n", name, r, ok.load(), unique);
+			return false;
+		}
+
+		boost::thread_group closers;
+		start = Clock::now();
+		for (size_t t = 0; t < nthreads; t++)
+			closers.create_thread(boost::bind(disconnect<Login>, &mgr, &clients, &accepted, nthreads, t));
+		closers.join_all();
+		logout_ns += elapsedNs(start);
+	}
+
+	size_t total = rounds * clients.size();
+	printf("%-6s login %7.1f ns, logout %7.1f ns, storm of %zu in %.2f ms\n", name,
+			login_ns / total, logout_ns / total, clients.size(), login_ns / rounds / 1e6);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 50000;
+	size_t nthreads = argc > 2 ? strtoul(argv[2], NULL, 10) : 8;
+	size_t rounds = argc > 3 ? strtoul(argv[3], NULL, 10) : 10;
+	if (nthreads == 0 || rounds == 0) {
+		printf("need at least one thread and one round\n");
+		return 1;
+	}
+
+	// 32 位十六进制 guid, 与客户端上报的格式一致
+	std::vector<SessionPtr> clients(n);
+	size_t unique = 0;
+	for (size_t i = 0; i < n; i++) {
+		clients[i] = boost::make_shared<Session>();
+		if (i > 0 && i % DUP_EVERY == 0) {
+			clients[i]->guid = clients[i / 2]->guid;
+			clients[i]->key = clients[i / 2]->key;
+			continue;
+		}
+
+		char guid[33];
+		snprintf(guid, sizeof(guid), "%08zx%08x%08x%08zx", i, 0x9e3779b9u, 0x85ebca6bu, i * 2654435761u);
+		clients[i]->guid = guid;
+		clients[i]->key = CHashedString(clients[i]->guid);
+		unique++;
+	}
+
+	printf("%zu clients (%zu unique guids), %zu threads, %zu rounds, %u cpus\n",
+			n, unique, nthreads, rounds, boost::thread::hardware_concurrency());
+	if (!bench<CSetLogin>("set", nthreads, rounds, unique, clients)
+			|| !bench<CIndexLogin>("index", nthreads, rounds, unique, clients))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * pktbuf_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 发送缓冲分配压测: CPktBuf 池与 new/delete 对比, 以及跨线程释放 (会话线程分配, 别的线程发完释放)
+ * 时的吞吐和常驻内存. 跨线程释放的缓冲应回到分配线程的池, 常驻内存不随轮数增长.
+ * 每行附带平均每次的 operator new 次数, 池热起来后同线程应为 0; 跨线程时释放线程落后,
+ * 在途缓冲超过 MAX_CACHED 的部分会被释放再新建, 次数随落后程度变化.
+ * 编译: g++ -std=c++98 -O2 -Isrc tools/pktbuf_bench.cpp src/net/CPktBuf.cpp -o pktbuf_bench \
+ *       -lboost_thread -lboost_chrono -lboost_system -lpthread
+ * 用法: pktbuf_bench [次数, 默认 10000000]
+ */
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+
+#include "net/CPktBuf.hpp"
+#define BENCH_COUNT_NEW
+#include "bench.hpp"
+
+extern "C"
+{
+#include <string.h>
+#include <unistd.h>
+}
+
+using bench::Clock;
+
+static const size_t PKT_LEN = 48;	// 典型控制协议应答
+static const size_t BATCH = 256;	// 跨线程每批交接的缓冲数
+
+static double newsPerOp(uint64_t start, size_t n)
+{
+	return static_cast<double>(bench::news() - start) / n;
+}
+
+static void benchLocal(size_t n)
+{
+	CPktBuf::alloc(PKT_LEN);	// 先建好本线程的池
+	uint64_t news = bench::news();
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		PktBufPtr buf = CPktBuf::alloc(PKT_LEN);
+		buf->data()[0] = static_cast<char>(i);
+	}
+	double ns = bench::nsPerOp(start, n);
+	printf("%-28s %8.1f ns/op %6.3f news/op\n", "pktbuf same thread", ns, newsPerOp(news, n));
+
+	news = bench::news();
+	start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		char* buf = new char[PKT_LEN];
+		buf[0] = static_cast<char>(i);
+		delete[] buf;
+	}
+	ns = bench::nsPerOp(start, n);
+	printf("%-28s %8.1f ns/op %6.3f news/op\n", "new/delete same thread", ns, newsPerOp(news, n));
+}
+
+// 释放线程: 取走一批后在本线程释放
+class CReleaser
+{
+public:
+	CReleaser() : _done(false) {}
+
+	void push(std::vector<PktBufPtr>& batch) {
+		boost::mutex::scoped_lock lk(_mutex);
+		_queue.insert(_queue.end(), batch.begin(), batch.end());
+		batch.clear();
+		_cond.notify_one();
+	}
+
+	void stop() {
+		boost::mutex::scoped_lock lk(_mutex);
+		_done = true;
+		_cond.notify_one();
+	}
+
+	void run() {
+		std::vector<PktBufPtr> batch;
+		for (;;) {
+			{
+				boost::mutex::scoped_lock lk(_mutex);
+				while (_queue.empty() && !_done)
+					_cond.wait(lk);
+				if (_queue.empty() && _done)
+					return;
+				batch.swap(_queue);
+			}
+			batch.clear();
+		}
+	}
+
+private:
+	boost::mutex _mutex;
+	boost::condition_variable _cond;
+	std::vector<PktBufPtr> _queue;	// 与取走的批次交换, 容量来回复用
+	bool _done;
+};
+
+static void benchRemote(size_t n)
+{
+	CReleaser releaser;
+	boost::thread th(boost::bind(&CReleaser::run, &releaser));
+
+	std::vector<PktBufPtr> batch;
+	batch.reserve(BATCH);
+	long rss_start = bench::rssKb();
+	long rss_half = 0;
+	uint64_t news_half = 0;
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < n; i++) {
+		batch.push_back(CPktBuf::alloc(PKT_LEN));
+		if (batch.size() == BATCH)
+			releaser.push(batch);
+		if (i == n / 2) {
+			rss_half = bench::rssKb();
+			news_half = bench::news();
+		}
+	}
+	releaser.push(batch);
+	double ns = bench::nsPerOp(start, n);
+	// 前一半里池和批次容器还在长, 只算后一半
+	double news = newsPerOp(news_half, n - n / 2);
+	releaser.stop();
+	th.join();
+
+	printf("%-28s %8.1f ns/op %6.3f news/op (2nd half), rss %ld KB -> %ld KB (half) -> %ld KB (end)\n",
+			"pktbuf cross thread", ns, news, rss_start, rss_half, bench::rssKb());
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+	benchLocal(n);
+	benchRemote(n);
+	return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * relay_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 通道转发吞吐: 回环上建一条通道, 源端按窗口连续发数据报, 目的端收, 比较通道流量计数开和关.
+ * 计数在通道构造时从 CWorkerTraffic 读取, 每轮新建 io_context 和通道, 开关交替跑几轮取最好的一次.
+ * 客户端收发和转发在同一线程, 结果是整条路径的单包耗时, 计数本身只占其中很小一部分.
+ * 编译: g++ -std=c++98 -O2 -Isrc -DBOOST_COROUTINES_NO_DEPRECATION_WARNING tools/relay_bench.cpp \
+ *       $(find src/net src/util -name '*.cpp') -o relay_bench \
+ *       -lboost_log -lboost_log_setup -lboost_thread -lboost_coroutine -lboost_context \
+ *       -lboost_chrono -lboost_filesystem -lboost_system -lrt -lpthread
+ * 用法: relay_bench [每轮包数, 默认 200000] [包长, 默认 1200] [批量收发, 默认 1]
+ */
+
+#include <string>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/log/core.hpp>
+
+#include "net/CBufferPool.hpp"
+#include "net/CChannel.hpp"
+#include "net/CSession.hpp"
+#include "net/CTraffic.hpp"
+#include "bench.hpp"
+
+using bench::Clock;
+
+static const int ROUNDS = 3;
+
+// 发认证包并等回显, 通道端据此记下远端地址
+static bool auth(asio::io_context& io, asio::ip::udp::socket& peer, const asio::ip::udp::endpoint& to)
+{
+	char buf[64];
+	boost::system::error_code ec;
+	peer.send_to(asio::buffer("auth", 4), to);
+	for (int i = 0; i < 1000; i++) {
+		bench::pump(io);
+		if (peer.receive(asio::buffer(buf), 0, ec) > 0 && !ec)
+			return true;
+	}
+	return false;
+}
+
+struct Result
+{
+	double ns;	// 每个转发成功的包
+	size_t lost;
+	uint64_t counted;
+};
+
+static bool run(size_t n, size_t len, uint32_t batch, bool counters, Result& res)
+{
+	asio::io_context io;
+	asio::use_service<CWorkerTraffic>(io).init(counters);
+	asio::use_service<CBufferPool>(io).init(1500, 256, false);
+
+	asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address::from_string("127.0.0.1"), 0));
+	asio::ip::tcp::socket src_peer(io);
+	asio::ip::tcp::socket dst_peer(io);
+	bench::Manager mgr;
+	SessionPtr src_ss = bench::connect(mgr, io, acceptor, src_peer, "127.0.0.2", 1);
+	SessionPtr dst_ss = bench::connect(mgr, io, acceptor, dst_peer, "127.0.0.3", 2);
+
+	ChannelPtr chann = boost::make_shared<CChannel>(boost::ref(io), 1, 1500, 0, 0, batch, false, false);
+	if (!chann->init(src_ss, dst_ss)) {
+		printf("channel init failed\n");
+		return false;
+	}
+	chann->start();
+	bench::pump(io);
+
+	asio::ip::udp::socket src(io, asio::ip::udp::endpoint(asio::ip::address::from_string("127.0.0.2"), 0));
+	asio::ip::udp::socket dst(io, asio::ip::udp::endpoint(asio::ip::address::from_string("127.0.0.3"), 0));
+	dst.non_blocking(true);
+	src.non_blocking(true);
+	if (!auth(io, dst, chann->dstEndpoint()) || !auth(io, src, chann->srcEndpoint())) {
+		printf("channel auth failed\n");
+		return false;
+	}
+
+	std::string payload(len, 'x');
+	asio::ip::udp::endpoint to = chann->srcEndpoint();
+	char buf[2048];
+	boost::system::error_code ec;
+	size_t sent = 0, received = 0;
+	// 通道 socket 的收发缓冲只有 mtu * 批量大小, 在途包数超过批量大小就会被内核丢掉
+	size_t window = batch;
+
+	Clock::time_point start = Clock::now();
+	while (sent < n) {
+		size_t burst = std::min(window, n - sent);
+		for (size_t i = 0; i < burst; i++)
+			src.send_to(asio::buffer(payload), to);
+		sent += burst;
+
+		// 收齐这一窗, 连续空转说明有包丢了
+		for (int idle = 0; received < sent && idle < 100; ) {
+			bench::pump(io);
+			size_t got = 0;
+			while (dst.receive(asio::buffer(buf), 0, ec) > 0 && !ec)
+				got++;
+			received += got;
+			idle = got ? 0 : idle + 1;
+		}
+	}
+	double elapsed = static_cast<double>(boost::chrono::duration_cast<boost::chrono::nanoseconds>(Clock::now() - start).count());
+
+	CTrafficTotal total;
+	chann->traffic(total);
+	res.ns = received ? elapsed / received : 0;
+	res.lost = sent - received;
+	res.counted = total.up_packs;
+
+	chann->stop();
+	chann.reset();
+	bench::pump(io);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+	size_t len = argc > 2 ? strtoul(argv[2], NULL, 10) : 1200;
+	uint32_t batch = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+	boost::log::core::get()->set_logging_enabled(false);
+
+	Result best[2];
+	for (int i = 0; i < 2; i++)
+		best[i].ns = 0;
+
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int on = 0; on < 2; on++) {
+			Result res;
+			if (!run(n, len, batch, on == 1, res))
+				return 1;
+			if (best[on].ns == 0 || res.ns < best[on].ns)
+				best[on] = res;
+		}
+	}
+
+	for (int on = 1; on >= 0; on--) {
+		printf("counters %-3s %8.1f ns/pkt %10.0f pkt/s, lost %zu, counted %llu\n",
+				on ? "on" : "off", best[on].ns, 1e9 / best[on].ns, best[on].lost,
+				static_cast<unsigned long long>(best[on].counted));
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * session_registry_bench.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: root
+ *
+ * 会话表 (id --> 会话) 多线程争用压测, 对比三种实现:
+ *   mutex   原来的单锁 unordered_map<id, weak_ptr>
+ *   sharded CShardedMap, 64 段各自加锁
+ *   slab    CSlabTable, 读不加锁, 现在 CSessionMgr 用的
+ * 预先登记 N 个会话, 每个线程 90% 随机查找 (代理请求查目的会话), 10% 关闭自己名下的一个会话再重新登录.
+ * 单核机器上线程轮流跑, 看不出真实争用, 结果要在多核上看.
+ * 编译: g++ -std=c++98 -O2 -Isrc tools/session_registry_bench.cpp -o session_registry_bench \
+ *       -lboost_thread -lboost_chrono -lboost_system -lpthread
+ * 用法: session_registry_bench [线程数, 默认 8] [会话数, 默认 100000] [每线程操作数, 默认 2000000]
+ */
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <boost/chrono.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "util/CShardedMap.hpp"
+#include "util/CSlabTable.hpp"
+
+typedef boost::chrono::steady_clock Clock;
+
+struct Session
+{
+	uint32_t id;
+};
+typedef boost::shared_ptr<Session> SessionPtr;
+typedef boost::weak_ptr<Session> SessionWptr;
+
+// 原来的 _ss_map + _ss_mutex
+class CMutexRegistry
+{
+public:
+	uint32_t add(uint32_t id, const SessionPtr& ss) {
+		boost::mutex::scoped_lock lk(_mutex);
+		_map[id] = ss;
+		return id;
+	}
+
+	SessionPtr get(uint32_t id) {
+		boost::mutex::scoped_lock lk(_mutex);
+		boost::unordered_map<uint32_t, SessionWptr>::iterator it = _map.find(id);
+		return it == _map.end() ? SessionPtr() : it->second.lock();
+	}
+
+	void remove(uint32_t id) {
+		boost::mutex::scoped_lock lk(_mutex);
+		_map.erase(id);
+	}
+
+private:
+	boost::mutex _mutex;
+	boost::unordered_map<uint32_t, SessionWptr> _map;
+};
+
+class CShardedRegistry
+{
+public:
+	uint32_t add(uint32_t id, const SessionPtr& ss) {
+		_map.insert(id, ss);
+		return id;
+	}
+
+	SessionPtr get(uint32_t id) {
+		SessionWptr wp;
+		return _map.get(id, wp) ? wp.lock() : SessionPtr();
+	}
+
+	void remove(uint32_t id) {
+		_map.remove(id);
+	}
+
+private:
+	CShardedMap<uint32_t, SessionWptr> _map;
+};
+
+// 槽位表自己分配 id, 重新登录换新 id
+class CSlabRegistry
+{
+public:
+	uint32_t add(uint32_t, const SessionPtr& ss) {
+		return _table.insert(ss);
+	}
+
+	SessionPtr get(uint32_t id) {
+		return _table.get(id);
+	}
+
+	void remove(uint32_t id) {
+		_table.remove(id);
+	}
+
+private:
+	CSlabTable<Session> _table;
+};
+
+// 防止结果被优化掉
+static boost::atomic<uint64_t> hits(0);
+
+template <typename Registry>
+static void worker(Registry* reg, boost::atomic<uint32_t>* ids, std::vector<SessionPtr>* sessions,
+		size_t nthreads, size_t tid, size_t ops)
+{
+	size_t n = sessions->size();
+	uint32_t seed = static_cast<uint32_t>(tid) * 2654435761u + 1;
+	uint64_t found = 0;
+
+	for (size_t i = 0; i < ops; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		if (seed % 10 != 0) {
+			if (reg->get(ids[seed % n].load(boost::memory_order_relaxed)))
+				found++;
+			continue;
+		}
+
+		// 只动自己名下 (下标模线程数等于 tid) 的会话, 登记和关闭不会互相踩
+		size_t k = (seed / 10 % (n / nthreads)) * nthreads + tid;
+		if (k >= n)
+			continue;
+
+		reg->remove(ids[k].load(boost::memory_order_relaxed));
+		ids[k].store(reg->add(static_cast<uint32_t>(k), (*sessions)[k]), boost::memory_order_relaxed);
+	}
+	hits += found;
+}
+
+template <typename Registry>
+static void bench(const char* name, size_t nthreads, size_t n, size_t ops)
+{
+	Registry reg;
+	std::vector<SessionPtr> sessions(n);
+	boost::atomic<uint32_t>* ids = new boost::atomic<uint32_t>[n];
+	for (size_t i = 0; i < n; i++) {
+		sessions[i] = boost::make_shared<Session>();
+		sessions[i]->id = i;
+		ids[i].store(reg.add(i, sessions[i]));
+	}
+
+	hits = 0;
+	boost::thread_group threads;
+	Clock::time_point start = Clock::now();
+	for (size_t t = 0; t < nthreads; t++)
+		threads.create_thread(boost::bind(worker<Registry>, &reg, ids, &sessions, nthreads, t, ops));
+	threads.join_all();
+	double secs = static_cast<double>(boost::chrono::duration_cast<boost::chrono::microseconds>(Clock::now() - start).count()) / 1e6;
+
+	size_t total = nthreads * ops;
+	printf("%-8s %10.0f ops/s %8.1f ns/op, hit %.1f%%\n", name, total / secs, secs * 1e9 / total,
+			100.0 * hits.load() / (total * 0.9));
+	delete[] ids;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t nthreads = argc > 1 ? strtoul(argv[1], NULL, 10) : 8;
+	size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : 100000;
+	size_t ops = argc > 3 ? strtoul(argv[3], NULL, 10) : 2000000;
+	if (nthreads == 0 || n < nthreads) {
+		printf("need at least one thread and one session per thread\n");
+		return 1;
+	}
+
+	printf("%zu threads, %zu sessions, %zu ops/thread, %u cpus\n", nthreads, n, ops, boost::thread::hardware_concurrency());
+	bench<CMutexRegistry>("mutex", nthreads, n, ops);
+	bench<CShardedRegistry>("sharded", nthreads, n, ops);
+	bench<CSlabRegistry>("slab", nthreads, n, ops);
+	return 0;
+}